@@ -5,11 +5,36 @@ out vec4 FragColor;
 in vec2 texCoord; //coming from vertex shader
 in vec4 color;
 in float texIndex;
+flat in float shapeType;
+flat in vec4 shapeParams;
 
 uniform sampler2D textures[16]; //"16" should be dynamic somehow
 
+//signed distance to a box centered at the origin with rounded corners (negative inside)
+float roundedBoxDistance(vec2 p, vec2 halfSize, float radius)
+{
+    vec2 q = abs(p) - halfSize + radius;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+}
+
 void main()
 {
     int tIndex = int(texIndex);
-    FragColor = texture(textures[tIndex], texCoord) * color;
+    FragColor = texture(textures[tIndex], texCoord) * color; //both premultiplied by alpha
+
+    if (shapeType > 0.5) //vector shape, see SpriteBatch::Shape
+    {
+        vec2 p = (texCoord - 0.5) * 2.0 * shapeParams.xy; //position inside the shape, in world units
+        float d;
+        if (shapeType < 1.5) //circle
+            d = length(p) - min(shapeParams.x, shapeParams.y);
+        else //rounded rect (and lines)
+            d = roundedBoxDistance(p, shapeParams.xy, shapeParams.z);
+
+        if (shapeParams.w > 0.0) //outline only, thickness grows inwards
+            d = abs(d + shapeParams.w * 0.5) - shapeParams.w * 0.5;
+
+        float aa = fwidth(d); //one pixel, the edge fades inside the quad so nothing gets cut
+        FragColor *= 1.0 - smoothstep(-aa, 0.0, d); //premultiplied, coverage scales the color too
+    }
 }
\ No newline at end of file
@@ -3,10 +3,14 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec4 aColor;
 layout (location = 2) in vec2 aTexCoord; // the texcoord variable has attribute position 2
 layout (location = 3) in float aTexID;
+layout (location = 4) in float aShapeType;
+layout (location = 5) in vec4 aShapeParams;
 
 out vec2 texCoord;
 out vec4 color;
 out float texIndex;
+flat out float shapeType;
+flat out vec4 shapeParams;
 
 uniform mat4 model;
 uniform mat4 view;
@@ -18,4 +22,6 @@ void main()
 	texCoord = aTexCoord;
 	color = aColor;
 	texIndex = aTexID;
+	shapeType = aShapeType;
+	shapeParams = aShapeParams;
 };
\ No newline at end of file
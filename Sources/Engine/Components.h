@@ -0,0 +1,23 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <glm/glm.hpp>
+#include <memory>
+
+class Texture;
+
+struct Transform
+{
+	glm::vec3 position = glm::vec3(0.0f); //z is the sprite layer (SpriteBatch depth)
+	glm::vec2 scale = glm::vec2(1.0f);
+};
+
+struct SpriteRenderer
+{
+	std::shared_ptr<Texture> texture; //a TextureCache handle, nullptr draws a colored quad
+	glm::vec4 color = glm::vec4(1.0f);
+	glm::vec2 size = glm::vec2(1.0f); //before scaling
+	bool visible = true;
+};
+
+#endif
@@ -0,0 +1,257 @@
+#include "FileWatcher.h"
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static const std::chrono::milliseconds settleTime(100); //quiet time before a changed file is reported
+
+FileWatcher::~FileWatcher()
+{
+	stop();
+}
+
+void FileWatcher::notePath(const std::string& relativePath)
+{
+	pending[relativePath] = std::chrono::steady_clock::now(); //later changes push the report back
+}
+
+std::vector<std::string> FileWatcher::poll()
+{
+	std::vector<std::string> changed;
+	if (!isWatching())
+		return changed;
+
+	readEvents();
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	for (auto it = pending.begin(); it != pending.end();)
+	{
+		if (now - it->second < settleTime)
+		{
+			++it;
+			continue;
+		}
+
+		std::string path = directory + "/" + it->first;
+		std::error_code error;
+		if (std::filesystem::is_regular_file(path, error)) //not if it was deleted again or is a directory
+			changed.push_back(path);
+		it = pending.erase(it);
+	}
+
+	return changed;
+}
+
+#ifdef _WIN32
+bool FileWatcher::start(const std::string& directory)
+{
+	stop();
+
+	HANDLE handle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "ERROR::FILE_WATCHER::OPEN_FAILED " << directory << std::endl;
+		return false;
+	}
+
+	OVERLAPPED* read = new OVERLAPPED();
+	read->hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+
+	this->directory = std::filesystem::path(directory).lexically_normal().generic_string();
+	directoryHandle = handle;
+	overlapped = read;
+	buffer.resize(16 * 1024); //64KB, more than that fails on network drives
+
+	if (!issueRead())
+	{
+		stop();
+		return false;
+	}
+	return true;
+}
+
+bool FileWatcher::issueRead()
+{
+	OVERLAPPED* read = (OVERLAPPED*)overlapped;
+	ResetEvent(read->hEvent);
+
+	DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+	readPending = ReadDirectoryChangesW((HANDLE)directoryHandle, buffer.data(), (DWORD)(buffer.size() * sizeof(unsigned long)), TRUE, filter, nullptr, read, nullptr) != 0;
+	if (!readPending)
+		std::cout << "ERROR::FILE_WATCHER::READ_FAILED " << directory << std::endl;
+	return readPending;
+}
+
+void FileWatcher::readEvents()
+{
+	DWORD length = 0;
+	while (readPending && GetOverlappedResult((HANDLE)directoryHandle, (OVERLAPPED*)overlapped, &length, FALSE)) //fails with ERROR_IO_INCOMPLETE until something changed
+	{
+		readPending = false;
+		if (length == 0) //the buffer overflowed and the changes are lost
+			std::cout << "ERROR::FILE_WATCHER::OVERFLOW " << directory << std::endl;
+
+		const unsigned char* record = (const unsigned char*)buffer.data();
+		while (length > 0)
+		{
+			const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)record;
+			if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+			{
+				int wideLength = (int)(info->FileNameLength / sizeof(WCHAR));
+				int size = WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, nullptr, 0, nullptr, nullptr);
+				std::string relativePath(size, '\0');
+				WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, &relativePath[0], size, nullptr, nullptr);
+				notePath(std::filesystem::path(relativePath).generic_string());
+			}
+
+			if (info->NextEntryOffset == 0)
+				break;
+			record += info->NextEntryOffset;
+		}
+
+		if (!issueRead())
+			return;
+	}
+}
+
+void FileWatcher::stop()
+{
+	OVERLAPPED* read = (OVERLAPPED*)overlapped;
+	if (readPending)
+	{
+		DWORD length;
+		CancelIoEx((HANDLE)directoryHandle, read);
+		GetOverlappedResult((HANDLE)directoryHandle, read, &length, TRUE); //the OS writes into buffer until it's cancelled
+	}
+	if (read != nullptr)
+	{
+		CloseHandle(read->hEvent);
+		delete read;
+	}
+	if (directoryHandle != nullptr)
+		CloseHandle(directoryHandle);
+
+	directoryHandle = nullptr;
+	overlapped = nullptr;
+	readPending = false;
+	buffer.clear();
+	pending.clear();
+}
+
+bool FileWatcher::isWatching() const
+{
+	return directoryHandle != nullptr;
+}
+#else
+bool FileWatcher::start(const std::string& directory)
+{
+	stop();
+
+	inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyDescriptor < 0)
+	{
+		std::cout << "ERROR::FILE_WATCHER::INIT_FAILED" << std::endl;
+		return false;
+	}
+
+	this->directory = std::filesystem::path(directory).lexically_normal().generic_string();
+	if (this->directory.size() > 1 && this->directory.back() == '/')
+		this->directory.pop_back();
+
+	addWatch("");
+	if (watchedDirectories.empty())
+	{
+		stop();
+		return false;
+	}
+	return true;
+}
+
+//inotify isn't recursive, every directory gets a watch of its own
+void FileWatcher::addWatch(const std::string& relativePath)
+{
+	std::string path = relativePath.empty() ? directory : directory + "/" + relativePath;
+	int watch = inotify_add_watch(inotifyDescriptor, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+	if (watch < 0)
+	{
+		std::cout << "ERROR::FILE_WATCHER::WATCH_FAILED " << path << std::endl;
+		return;
+	}
+	watchedDirectories[watch] = relativePath;
+
+	std::error_code error;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(path, error))
+	{
+		if (entry.is_directory(error))
+		{
+			std::string name = entry.path().filename().generic_string();
+			addWatch(relativePath.empty() ? name : relativePath + "/" + name);
+		}
+	}
+}
+
+void FileWatcher::readEvents()
+{
+	alignas(struct inotify_event) char events[16 * 1024];
+	while (true)
+	{
+		ssize_t length = read(inotifyDescriptor, events, sizeof(events));
+		if (length <= 0) //EAGAIN, nothing else queued
+			break;
+
+		for (const char* record = events; record < events + length;)
+		{
+			const struct inotify_event* event = (const struct inotify_event*)record;
+			record += sizeof(struct inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				std::cout << "ERROR::FILE_WATCHER::OVERFLOW " << directory << std::endl;
+				continue;
+			}
+			if (event->mask & IN_IGNORED) //the directory was removed
+			{
+				watchedDirectories.erase(event->wd);
+				continue;
+			}
+
+			auto it = watchedDirectories.find(event->wd);
+			if (it == watchedDirectories.end() || event->len == 0)
+				continue;
+
+			std::string relativePath = it->second.empty() ? std::string(event->name) : it->second + "/" + event->name;
+			if (event->mask & IN_ISDIR)
+			{
+				if (event->mask & (IN_CREATE | IN_MOVED_TO))
+					addWatch(relativePath);
+			}
+			else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) //created files show up again when they're closed
+				notePath(relativePath);
+		}
+	}
+}
+
+void FileWatcher::stop()
+{
+	if (inotifyDescriptor >= 0)
+		close(inotifyDescriptor); //drops the watches with it
+
+	inotifyDescriptor = -1;
+	watchedDirectories.clear();
+	pending.clear();
+}
+
+bool FileWatcher::isWatching() const
+{
+	return inotifyDescriptor >= 0;
+}
+#endif
@@ -0,0 +1,46 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//reports files written under a directory (subdirectories included) while the program runs, for hot reloading assets
+//inotify on linux, ReadDirectoryChangesW on windows, poll never blocks: it only drains what the OS queued since
+//editors save in several steps (truncate, write, rename over...), a path is only reported once it stayed quiet for a bit
+class FileWatcher
+{
+public:
+	FileWatcher() = default;
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	bool start(const std::string& directory);
+	void stop();
+	bool isWatching() const;
+
+	//full paths ('/' separated) of the files that changed and settled since the last call, each one once
+	std::vector<std::string> poll();
+private:
+	void readEvents(); //moves what the OS queued into pending
+	void notePath(const std::string& relativePath);
+
+	std::string directory;
+	std::unordered_map<std::string, std::chrono::steady_clock::time_point> pending; //path, last change
+#ifdef _WIN32
+	void* directoryHandle = nullptr;
+	void* overlapped = nullptr; //OVERLAPPED of the read in flight
+	std::vector<unsigned long> buffer; //FILE_NOTIFY_INFORMATION records, DWORD aligned
+	bool readPending = false;
+	bool issueRead();
+#else
+	int inotifyDescriptor = -1;
+	std::unordered_map<int, std::string> watchedDirectories; //watch descriptor, path relative to the root ("" for it)
+	void addWatch(const std::string& relativePath); //and every directory below it
+#endif
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include "RenderProxy.h"
+
+RenderProxyBuffer::RenderProxyBuffer(int maxFramesInFlight)
+	: buffers(maxFramesInFlight < 1 ? 2 : maxFramesInFlight + 1)
+{
+}
+
+//the oldest array, the frames still queued on the render thread use the ones after it
+std::vector<RenderProxy>& RenderProxyBuffer::beginWrite()
+{
+	std::vector<RenderProxy>& buffer = buffers[(published + 1) % buffers.size()];
+	buffer.clear(); //keeps the capacity, no allocations once the scene size settles
+	return buffer;
+}
+
+void RenderProxyBuffer::publish()
+{
+	published = (published + 1) % (int)buffers.size();
+}
+
+const std::vector<RenderProxy>& RenderProxyBuffer::getPublished() const
+{
+	return buffers[published];
+}
+
+void RenderProxyBuffer::clear()
+{
+	for (std::vector<RenderProxy>& buffer : buffers)
+		buffer.clear();
+}
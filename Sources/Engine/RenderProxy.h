@@ -0,0 +1,37 @@
+#ifndef RENDER_PROXY_H
+#define RENDER_PROXY_H
+
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Texture;
+
+//everything the renderer needs to draw one sprite, copied out of the registry so rendering never touches live ecs state
+struct RenderProxy
+{
+	glm::vec2 position;
+	glm::vec2 size;
+	glm::vec4 color;
+	float depth;
+	std::shared_ptr<Texture> texture; //a handle, a sprite destroyed meanwhile can't free it before this frame rendered
+};
+
+//ring of proxy arrays: the game thread extracts into one while the renderer submits the others, one array per frame the
+//renderer can be behind (RenderThread's maxFramesInFlight) plus the one being written, the textures of a frame are
+//released when its array is cleared for reuse, after that frame executed
+class RenderProxyBuffer
+{
+public:
+	explicit RenderProxyBuffer(int maxFramesInFlight = 1); //pass the same value as to RenderThread::start
+	std::vector<RenderProxy>& beginWrite(); //cleared array the next extraction fills
+	void publish(); //sync point, the written array becomes the one to render
+	const std::vector<RenderProxy>& getPublished() const; //capture this (not the buffer) in the render command
+	void clear(); //once nothing renders anymore, drops the texture handles of every array
+
+private:
+	std::vector<std::vector<RenderProxy>> buffers;
+	int published = 0;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+//lock-free bounded queue for exactly one producer thread and one consumer thread
+//capacity must be a power of 2, one slot is kept empty to tell a full queue from an empty one
+template <typename T, size_t Capacity>
+class SPSCQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of 2");
+public:
+	bool push(T&& value) //producer only, false if full
+	{
+		size_t tail = tailIndex.load(std::memory_order_relaxed);
+		size_t next = (tail + 1) & (Capacity - 1);
+		if (next == headIndex.load(std::memory_order_acquire))
+			return false;
+
+		items[tail] = std::move(value);
+		tailIndex.store(next, std::memory_order_release); //publishes the item
+		return true;
+	}
+
+	bool pop(T& value) //consumer only, false if empty
+	{
+		size_t head = headIndex.load(std::memory_order_relaxed);
+		if (head == tailIndex.load(std::memory_order_acquire))
+			return false;
+
+		value = std::move(items[head]);
+		items[head] = T(); //release whatever the item holds now, not when the slot gets overwritten
+		headIndex.store((head + 1) & (Capacity - 1), std::memory_order_release); //gives the slot back
+		return true;
+	}
+
+	bool empty() const
+	{
+		return headIndex.load(std::memory_order_acquire) == tailIndex.load(std::memory_order_acquire);
+	}
+
+private:
+	T items[Capacity];
+	alignas(64) std::atomic<size_t> headIndex{ 0 }; //written by the consumer
+	alignas(64) std::atomic<size_t> tailIndex{ 0 }; //written by the producer, on its own cache line
+};
+
+#endif
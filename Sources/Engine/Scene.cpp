@@ -1 +1,18 @@
 #include "Scene.h"
+
+void Scene::extractRenderProxies(RenderProxyBuffer& proxies)
+{
+	std::vector<RenderProxy>& target = proxies.beginWrite();
+
+	auto view = reg.view<Transform, SpriteRenderer>();
+	target.reserve(view.size_hint());
+	for (auto [entity, transform, sprite] : view.each())
+	{
+		if (!sprite.visible)
+			continue;
+
+		target.push_back({ glm::vec2(transform.position), sprite.size * transform.scale, sprite.color, transform.position.z, sprite.texture });
+	}
+
+	proxies.publish();
+}
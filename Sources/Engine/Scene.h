@@ -2,6 +2,8 @@
 #define SCENE_H
 
 #include <entt/entt.hpp>
+#include "Components.h"
+#include "RenderProxy.h"
 
 class Scene
 {
@@ -15,8 +17,20 @@ public:
 		//create an entity
 		//assign a transform
 		//initialize tag and name
+		entt::entity entity = reg.create();
+		reg.emplace<Transform>(entity);
+		return entity;
 	}
 
+	entt::registry& getRegistry()
+	{
+		return reg;
+	}
+
+	//render extraction: copies the visible sprites into the proxy buffer and publishes it, after this the
+	//simulation can change the registry freely while the renderer works on the published proxies
+	void extractRenderProxies(RenderProxyBuffer& proxies);
+
 	friend class Entity;
 };
 
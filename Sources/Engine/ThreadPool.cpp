@@ -0,0 +1,106 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = 1;
+
+	workers.reserve(threadCount);
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::enqueue(Job job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push(std::move(job));
+	}
+	jobAvailable.notify_one();
+}
+
+void ThreadPool::waitIdle()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this] { return jobs.empty() && runningCount == 0; });
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body)
+{
+	if (count == 0)
+		return;
+
+	size_t chunkCount = std::min(count, workers.size() * 4); //a few chunks per worker evens out uneven items
+	size_t remaining = chunkCount;
+	std::mutex doneMutex;
+	std::condition_variable done;
+
+	for (size_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		size_t begin = count * chunk / chunkCount;
+		size_t end = count * (chunk + 1) / chunkCount;
+		enqueue([&, begin, end]()
+			{
+				for (size_t i = begin; i < end; i++)
+					body(i);
+
+				std::lock_guard<std::mutex> lock(doneMutex);
+				if (--remaining == 0)
+					done.notify_one();
+			});
+	}
+
+	std::unique_lock<std::mutex> lock(doneMutex);
+	done.wait(lock, [&] { return remaining == 0; });
+}
+
+unsigned int ThreadPool::getThreadCount() const
+{
+	return (unsigned int)workers.size();
+}
+
+ThreadPool& ThreadPool::getShared()
+{
+	static ThreadPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1);
+	return pool;
+}
+
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+			if (jobs.empty()) //stopping and nothing left to run
+				return;
+
+			job = std::move(jobs.front());
+			jobs.pop();
+			runningCount++;
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			runningCount--;
+			if (jobs.empty() && runningCount == 0)
+				idle.notify_all();
+		}
+	}
+}
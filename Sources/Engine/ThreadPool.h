@@ -0,0 +1,42 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+//fixed set of worker threads running queued jobs in submission order, jobs must not touch GL (no context on workers)
+class ThreadPool
+{
+public:
+	typedef std::function<void()> Job;
+
+	explicit ThreadPool(unsigned int threadCount);
+	~ThreadPool(); //finishes the queued jobs and joins the workers
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void enqueue(Job job);
+	void waitIdle(); //blocks until the queue is empty and no job is running
+	//runs body(i) for i in [0, count) spread over the workers and blocks until all are done, don't call it from a job
+	void parallelFor(size_t count, const std::function<void(size_t)>& body);
+	unsigned int getThreadCount() const;
+
+	static ThreadPool& getShared(); //engine wide pool, one worker per core minus the main thread
+private:
+	void workerLoop();
+
+	std::vector<std::thread> workers;
+	std::queue<Job> jobs;
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable idle;
+	unsigned int runningCount = 0;
+	bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,316 @@
+#include "BlockCompression.h"
+#include "../Engine/ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCK_COMPRESSION_SSE2
+#include <emmintrin.h>
+#endif
+
+static unsigned short packColor565(const unsigned char* color)
+{
+	return (unsigned short)(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+}
+
+static void unpackColor565(unsigned short packed, unsigned char* color)
+{
+	int r = (packed >> 11) & 31;
+	int g = (packed >> 5) & 63;
+	int b = packed & 31;
+	color[0] = (unsigned char)((r << 3) | (r >> 2));
+	color[1] = (unsigned char)((g << 2) | (g >> 4));
+	color[2] = (unsigned char)((b << 3) | (b >> 2));
+	color[3] = 255;
+}
+
+//per channel min and max of the 16 rgba texels
+static void boundingBox(const unsigned char* block, unsigned char* minColor, unsigned char* maxColor)
+{
+#ifdef BLOCK_COMPRESSION_SSE2
+	__m128i row0 = _mm_loadu_si128((const __m128i*)block);
+	__m128i row1 = _mm_loadu_si128((const __m128i*)(block + 16));
+	__m128i row2 = _mm_loadu_si128((const __m128i*)(block + 32));
+	__m128i row3 = _mm_loadu_si128((const __m128i*)(block + 48));
+	__m128i minimum = _mm_min_epu8(_mm_min_epu8(row0, row1), _mm_min_epu8(row2, row3));
+	__m128i maximum = _mm_max_epu8(_mm_max_epu8(row0, row1), _mm_max_epu8(row2, row3));
+	//fold the 4 texels left in each register down to 1
+	minimum = _mm_min_epu8(minimum, _mm_shuffle_epi32(minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+	minimum = _mm_min_epu8(minimum, _mm_shuffle_epi32(minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+	maximum = _mm_max_epu8(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(1, 0, 3, 2)));
+	maximum = _mm_max_epu8(maximum, _mm_shuffle_epi32(maximum, _MM_SHUFFLE(2, 3, 0, 1)));
+	int packedMin = _mm_cvtsi128_si32(minimum);
+	int packedMax = _mm_cvtsi128_si32(maximum);
+	memcpy(minColor, &packedMin, 4);
+	memcpy(maxColor, &packedMax, 4);
+#else
+	memcpy(minColor, block, 4);
+	memcpy(maxColor, block, 4);
+	for (int i = 1; i < 16; i++)
+		for (int c = 0; c < 4; c++)
+		{
+			minColor[c] = std::min(minColor[c], block[i * 4 + c]);
+			maxColor[c] = std::max(maxColor[c], block[i * 4 + c]);
+		}
+#endif
+}
+
+static void encodeColorBlock(const unsigned char* block, const unsigned char* minColor, const unsigned char* maxColor, unsigned char* output)
+{
+	//pull the endpoints in a bit, the box corners are rarely hit by the texels
+	unsigned char inMin[4];
+	unsigned char inMax[4];
+	for (int c = 0; c < 3; c++)
+	{
+		int inset = (maxColor[c] - minColor[c]) >> 4;
+		inMin[c] = (unsigned char)std::min(minColor[c] + inset, 255);
+		inMax[c] = (unsigned char)std::max(maxColor[c] - inset, 0);
+	}
+
+	unsigned short color0 = packColor565(inMax);
+	unsigned short color1 = packColor565(inMin);
+	unsigned int indices = 0;
+
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	if (color0 != color1)
+	{
+		//project each texel on the endpoint axis and round to one of the 4 palette entries
+		unsigned char end0[4];
+		unsigned char end1[4];
+		unpackColor565(color0, end0);
+		unpackColor565(color1, end1);
+		int axis[3] = { end0[0] - end1[0], end0[1] - end1[1], end0[2] - end1[2] };
+		int lengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		static const unsigned int paletteIndex[4] = { 1, 3, 2, 0 }; //from the end1 (0) to the end0 (3) step
+
+		for (int i = 0; i < 16; i++)
+		{
+			const unsigned char* texel = block + i * 4;
+			int dot = (texel[0] - end1[0]) * axis[0] + (texel[1] - end1[1]) * axis[1] + (texel[2] - end1[2]) * axis[2];
+			int step = std::min(std::max((dot * 3 + lengthSquared / 2) / lengthSquared, 0), 3);
+			indices |= paletteIndex[step] << (i * 2);
+		}
+	}
+
+	output[0] = (unsigned char)(color0 & 0xff);
+	output[1] = (unsigned char)(color0 >> 8);
+	output[2] = (unsigned char)(color1 & 0xff);
+	output[3] = (unsigned char)(color1 >> 8);
+	memcpy(output + 4, &indices, 4); //little endian like the format
+}
+
+static void encodeAlphaBlock(const unsigned char* block, unsigned char minAlpha, unsigned char maxAlpha, unsigned char* output)
+{
+	output[0] = maxAlpha;
+	output[1] = minAlpha;
+
+	unsigned long long indices = 0;
+	if (maxAlpha != minAlpha)
+	{
+		int range = maxAlpha - minAlpha;
+		for (int i = 0; i < 16; i++)
+		{
+			int step = ((block[i * 4 + 3] - minAlpha) * 7 + range / 2) / range; //0 is alpha1, 7 is alpha0
+			unsigned long long index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+			indices |= index << (i * 3);
+		}
+	}
+
+	for (int i = 0; i < 6; i++)
+		output[2 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+//gathers a 4x4 block as rgba, texels outside the image repeat the edge
+static void fetchBlock(const unsigned char* pixels, int width, int height, int numberOfChannels, int blockX, int blockY, unsigned char* block)
+{
+	for (int y = 0; y < 4; y++)
+	{
+		int sourceY = std::min(blockY * 4 + y, height - 1);
+		for (int x = 0; x < 4; x++)
+		{
+			int sourceX = std::min(blockX * 4 + x, width - 1);
+			const unsigned char* texel = pixels + ((size_t)sourceY * width + sourceX) * numberOfChannels;
+			unsigned char* target = block + (y * 4 + x) * 4;
+			target[0] = texel[0];
+			target[1] = numberOfChannels > 1 ? texel[1] : texel[0];
+			target[2] = numberOfChannels > 2 ? texel[2] : texel[0];
+			target[3] = numberOfChannels == 4 ? texel[3] : numberOfChannels == 2 ? texel[1] : 255;
+		}
+	}
+}
+
+bool BlockCompression::isCompressedFormat(GLenum internalFormat)
+{
+	return getBlockBytes(internalFormat) != 0;
+}
+
+size_t BlockCompression::getBlockBytes(GLenum internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGB8_ETC2:
+	case GL_COMPRESSED_SRGB8_ETC2:
+	case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+	case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		return 8;
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RGBA_BPTC_UNORM_ARB:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB:
+	case GL_COMPRESSED_RGBA8_ETC2_EAC:
+	case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+size_t BlockCompression::getLevelSize(GLenum internalFormat, int width, int height)
+{
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * getBlockBytes(internalFormat);
+}
+
+bool BlockCompression::isSupported(GLenum internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		return GLAD_GL_EXT_texture_compression_s3tc != 0;
+	case GL_COMPRESSED_RGBA_BPTC_UNORM_ARB:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB:
+		return GLAD_GL_ARB_texture_compression_bptc != 0;
+	case GL_COMPRESSED_RGB8_ETC2:
+	case GL_COMPRESSED_SRGB8_ETC2:
+	case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+	case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+	case GL_COMPRESSED_RGBA8_ETC2_EAC:
+	case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+		return GLAD_GL_ARB_ES3_compatibility != 0;
+	default:
+		return false;
+	}
+}
+
+std::vector<unsigned char> BlockCompression::compress(const unsigned char* pixels, int width, int height, int numberOfChannels, GLenum internalFormat)
+{
+	bool hasAlpha = internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	size_t blockBytes = getBlockBytes(internalFormat);
+	int blocksX = (width + 3) / 4;
+	int blocksY = (height + 3) / 4;
+	std::vector<unsigned char> output((size_t)blocksX * blocksY * blockBytes);
+
+	ThreadPool::getShared().parallelFor(blocksY, [&](size_t blockY)
+		{
+			unsigned char block[64];
+			unsigned char minColor[4];
+			unsigned char maxColor[4];
+			for (int blockX = 0; blockX < blocksX; blockX++)
+			{
+				unsigned char* target = output.data() + ((size_t)blockY * blocksX + blockX) * blockBytes;
+				fetchBlock(pixels, width, height, numberOfChannels, blockX, (int)blockY, block);
+				boundingBox(block, minColor, maxColor);
+
+				if (hasAlpha)
+				{
+					encodeAlphaBlock(block, minColor[3], maxColor[3], target);
+					target += 8;
+				}
+				encodeColorBlock(block, minColor, maxColor, target);
+			}
+		});
+
+	return output;
+}
+
+static void decodeColorBlock(const unsigned char* input, bool allowTransparent, unsigned char* block)
+{
+	unsigned short color0 = (unsigned short)(input[0] | input[1] << 8);
+	unsigned short color1 = (unsigned short)(input[2] | input[3] << 8);
+	unsigned int indices;
+	memcpy(&indices, input + 4, 4);
+
+	unsigned char palette[4][4];
+	unpackColor565(color0, palette[0]);
+	unpackColor565(color1, palette[1]);
+	if (color0 > color1 || !allowTransparent)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (unsigned char)((2 * palette[0][c] + palette[1][c] + 1) / 3);
+			palette[3][c] = (unsigned char)((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+		}
+		palette[2][3] = 255;
+		palette[3][3] = 255;
+	}
+	else //3 colors and transparent black
+	{
+		for (int c = 0; c < 3; c++)
+			palette[2][c] = (unsigned char)((palette[0][c] + palette[1][c]) / 2);
+		palette[2][3] = 255;
+		memset(palette[3], 0, 4);
+	}
+
+	for (int i = 0; i < 16; i++)
+		memcpy(block + i * 4, palette[(indices >> (i * 2)) & 3], 4);
+}
+
+static void decodeAlphaBlock(const unsigned char* input, unsigned char* block)
+{
+	int alpha[8] = { input[0], input[1] };
+	if (alpha[0] > alpha[1])
+		for (int i = 2; i < 8; i++)
+			alpha[i] = ((8 - i) * alpha[0] + (i - 1) * alpha[1] + 3) / 7;
+	else
+	{
+		for (int i = 2; i < 6; i++)
+			alpha[i] = ((6 - i) * alpha[0] + (i - 1) * alpha[1] + 2) / 5;
+		alpha[6] = 0;
+		alpha[7] = 255;
+	}
+
+	unsigned long long indices = 0;
+	for (int i = 0; i < 6; i++)
+		indices |= (unsigned long long)input[2 + i] << (i * 8);
+
+	for (int i = 0; i < 16; i++)
+		block[i * 4 + 3] = (unsigned char)alpha[(indices >> (i * 3)) & 7];
+}
+
+bool BlockCompression::decompress(const unsigned char* blocks, int width, int height, GLenum internalFormat, unsigned char* rgba)
+{
+	bool isBC1 = internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	bool isBC3 = internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	if (!isBC1 && !isBC3)
+		return false;
+
+	size_t blockBytes = getBlockBytes(internalFormat);
+	int blocksX = (width + 3) / 4;
+	int blocksY = (height + 3) / 4;
+	unsigned char block[64];
+
+	for (int blockY = 0; blockY < blocksY; blockY++)
+		for (int blockX = 0; blockX < blocksX; blockX++)
+		{
+			const unsigned char* input = blocks + ((size_t)blockY * blocksX + blockX) * blockBytes;
+			if (isBC3)
+			{
+				decodeColorBlock(input + 8, false, block);
+				decodeAlphaBlock(input, block);
+			}
+			else
+				decodeColorBlock(input, internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, block);
+
+			for (int y = 0; y < 4 && blockY * 4 + y < height; y++)
+				for (int x = 0; x < 4 && blockX * 4 + x < width; x++)
+					memcpy(rgba + ((size_t)(blockY * 4 + y) * width + blockX * 4 + x) * 4, block + (y * 4 + x) * 4, 4);
+		}
+
+	return true;
+}
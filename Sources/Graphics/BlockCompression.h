@@ -0,0 +1,25 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+
+//S3TC block formats (4x4 texels per block): BC1 (8 bytes, opaque rgb) and BC3 (16 bytes, rgb + interpolated alpha)
+//the encoder is a bounding box fit (SSE2 when available) run over all blocks on the shared thread pool, made for the
+//offline cooker, the decoder is the fallback for drivers without GL_EXT_texture_compression_s3tc
+class BlockCompression
+{
+public:
+	static bool isCompressedFormat(GLenum internalFormat); //any block format GL knows about, not only the ones encoded here
+	static size_t getBlockBytes(GLenum internalFormat); //0 if it isn't a block format
+	static size_t getLevelSize(GLenum internalFormat, int width, int height);
+	static bool isSupported(GLenum internalFormat); //the driver exposes the extension for it (needs a loaded context)
+
+	//pixels are tightly packed with 3 or 4 channels, internalFormat is GL_COMPRESSED_RGB_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	static std::vector<unsigned char> compress(const unsigned char* pixels, int width, int height, int numberOfChannels, GLenum internalFormat);
+	//back to tightly packed rgba, false for formats it can't decode
+	static bool decompress(const unsigned char* blocks, int width, int height, GLenum internalFormat, unsigned char* rgba);
+};
+
+#endif
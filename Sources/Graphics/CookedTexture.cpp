@@ -0,0 +1,164 @@
+#include "CookedTexture.h"
+#include "BlockCompression.h"
+#include "../Engine/MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+static GLenum internalFormatFor(int numberOfChannels)
+{
+	static const GLenum formats[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+	return formats[numberOfChannels - 1];
+}
+
+static uint32_t fullChainLength(uint32_t width, uint32_t height) //levels down to 1x1
+{
+	uint32_t length = 1;
+	while ((width >> length) > 0 || (height >> length) > 0)
+		length++;
+	return length;
+}
+
+bool CookedTexture::isCookedPath(const char* name)
+{
+	size_t length = strlen(name);
+	return length >= 5 && strcmp(name + length - 5, ".gtex") == 0;
+}
+
+bool CookedTexture::read(const std::string& path, ImageData& image)
+{
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->open(path))
+		return false;
+
+	const unsigned char* data = file->getData();
+	size_t size = file->getSize();
+
+	Header header;
+	if (size < sizeof(Header))
+	{
+		std::cout << "ERROR::COOKED_TEXTURE::TRUNCATED " << path << std::endl;
+		return false;
+	}
+	memcpy(&header, data, sizeof(Header));
+
+	if (header.magic != magic || header.version != version)
+	{
+		std::cout << "ERROR::COOKED_TEXTURE::WRONG_VERSION " << path << " (recook it)" << std::endl;
+		return false;
+	}
+
+	size_t tableEnd = sizeof(Header) + header.levelCount * sizeof(Level) + header.outlineCount * sizeof(glm::vec2);
+	if (header.levelCount == 0 || header.levelCount > 32 || header.numberOfChannels < 1 || header.numberOfChannels > 4 || tableEnd > size
+		|| header.width == 0 || header.height == 0 || header.levelCount > fullChainLength(header.width, header.height))
+	{
+		std::cout << "ERROR::COOKED_TEXTURE::CORRUPT " << path << std::endl;
+		return false;
+	}
+
+	std::vector<Level> levels(header.levelCount);
+	memcpy(levels.data(), data + sizeof(Header), header.levelCount * sizeof(Level));
+
+	//everything that gets uploaded (or copied by the loader's workers) has to lie inside the mapping, levels in order
+	bool isCompressed = BlockCompression::isCompressedFormat(header.internalFormat);
+	uint64_t previousEnd = 0;
+	image.levels.clear();
+	for (uint32_t i = 0; i < header.levelCount; i++)
+	{
+		const Level& level = levels[i];
+		uint32_t width = std::max(header.width >> i, 1u); //each level halves the previous one
+		uint32_t height = std::max(header.height >> i, 1u);
+		uint64_t expectedSize = isCompressed ? BlockCompression::getLevelSize(header.internalFormat, (int)width, (int)height) : (uint64_t)width * height * header.numberOfChannels;
+
+		if (level.offset > size || level.size > size - level.offset || level.offset < previousEnd
+			|| level.width != width || level.height != height || level.size != expectedSize || expectedSize == 0)
+		{
+			std::cout << "ERROR::COOKED_TEXTURE::CORRUPT " << path << std::endl;
+			return false;
+		}
+		previousEnd = level.offset + level.size;
+		image.levels.push_back({ (int)level.width, (int)level.height, (size_t)(level.offset - levels[0].offset), (size_t)level.size });
+	}
+
+	image.outline.resize(header.outlineCount);
+	if (header.outlineCount > 0)
+		memcpy(image.outline.data(), data + sizeof(Header) + header.levelCount * sizeof(Level), header.outlineCount * sizeof(glm::vec2));
+
+	image.width = (int)header.width;
+	image.height = (int)header.height;
+	image.numberOfChannels = (int)header.numberOfChannels;
+	image.internalFormat = header.internalFormat;
+	image.isOpaque = (header.flags & Opaque) != 0;
+	image.pixels = const_cast<unsigned char*>(data + levels[0].offset); //read only mapping, never written
+	image.file = file;
+
+	if (BlockCompression::isCompressedFormat(image.internalFormat) && !BlockCompression::isSupported(image.internalFormat))
+		return decompressLevels(path, image);
+
+	return true;
+}
+
+bool CookedTexture::decompressLevels(const std::string& path, ImageData& image)
+{
+	std::vector<ImageLevel> levels;
+	size_t size = 0;
+	for (const ImageLevel& level : image.levels)
+	{
+		levels.push_back({ level.width, level.height, size, (size_t)level.width * level.height * 4 });
+		size += levels.back().size;
+	}
+
+	std::vector<unsigned char> storage(size);
+	for (size_t i = 0; i < levels.size(); i++)
+		if (!BlockCompression::decompress(image.pixels + image.levels[i].offset, levels[i].width, levels[i].height, image.internalFormat, storage.data() + levels[i].offset))
+		{
+			std::cout << "ERROR::COOKED_TEXTURE::FORMAT_NOT_SUPPORTED " << path << " (recook it uncompressed)" << std::endl;
+			return false;
+		}
+
+	//the mapping isn't needed anymore, the texture goes up as plain rgba
+	image.file.reset();
+	image.storage = std::make_shared<std::vector<unsigned char>>(std::move(storage));
+	image.pixels = image.storage->data();
+	image.levels = levels;
+	image.numberOfChannels = 4;
+	image.internalFormat = GL_RGBA8;
+	return true;
+}
+
+bool CookedTexture::write(const std::string& path, const ImageData& image, const std::vector<unsigned char>& levelData)
+{
+	Header header = {};
+	header.magic = magic;
+	header.version = version;
+	header.width = (uint32_t)image.width;
+	header.height = (uint32_t)image.height;
+	header.numberOfChannels = (uint32_t)image.numberOfChannels;
+	header.internalFormat = image.internalFormat != 0 ? (GLenum)image.internalFormat : internalFormatFor(image.numberOfChannels);
+	header.levelCount = (uint32_t)image.levels.size();
+	header.flags = image.isOpaque ? (uint32_t)Opaque : 0u;
+	header.outlineCount = (uint32_t)image.outline.size();
+
+	size_t tableEnd = sizeof(Header) + image.levels.size() * sizeof(Level) + image.outline.size() * sizeof(glm::vec2);
+	size_t dataStart = (tableEnd + dataAlignment - 1) & ~(dataAlignment - 1);
+
+	std::vector<Level> levels;
+	for (const ImageLevel& level : image.levels)
+		levels.push_back({ (uint32_t)level.width, (uint32_t)level.height, (uint64_t)(dataStart + level.offset), (uint64_t)level.size });
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "ERROR::COOKED_TEXTURE::CANT_WRITE " << path << std::endl;
+		return false;
+	}
+
+	static const char padding[dataAlignment] = {};
+	file.write((const char*)&header, sizeof(Header));
+	file.write((const char*)levels.data(), levels.size() * sizeof(Level));
+	file.write((const char*)image.outline.data(), image.outline.size() * sizeof(glm::vec2));
+	file.write(padding, dataStart - tableEnd);
+	file.write((const char*)levelData.data(), levelData.size());
+
+	return (bool)file;
+}
@@ -0,0 +1,53 @@
+#ifndef COOKED_TEXTURE_H
+#define COOKED_TEXTURE_H
+
+#include "Texture.h"
+#include <cstdint>
+#include <string>
+
+//.gtex container written by TextureCooker: header, level table, outline, then every mip level tightly packed (level 0
+//first) in the GL internal format it gets uploaded in, already flipped for GL and premultiplied, so loading is map + glTexSubImage2D
+//(or glCompressedTexImage2D for block formats, decoded in software when the driver doesn't expose them)
+class CookedTexture
+{
+public:
+	static const uint32_t magic = 0x58455447; //"GTEX"
+	static const uint32_t version = 2; //2: colors are premultiplied by alpha
+	static const size_t dataAlignment = 16; //start of the level data
+
+	enum Flags : uint32_t
+	{
+		Opaque = 1 << 0,
+	};
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t numberOfChannels;
+		uint32_t internalFormat; //GL enum
+		uint32_t levelCount;
+		uint32_t flags;
+		uint32_t outlineCount; //uv points after the level table
+		uint32_t reserved;
+	};
+
+	struct Level
+	{
+		uint32_t width;
+		uint32_t height;
+		uint64_t offset; //from the start of the file
+		uint64_t size;
+	};
+
+	static bool isCookedPath(const char* name);
+	static bool read(const std::string& path, ImageData& image); //maps the file, image.pixels points into it
+	//image holds level 0 and levels the offsets of the chain inside levelData (level 0 included)
+	static bool write(const std::string& path, const ImageData& image, const std::vector<unsigned char>& levelData);
+private:
+	static bool decompressLevels(const std::string& path, ImageData& image); //software fallback for missing block formats
+};
+
+#endif
@@ -0,0 +1,242 @@
+#include "GLState.h"
+
+static const GLuint unknown = 0xFFFFFFFF; //no GL name or enum has this value
+static const unsigned int maxTrackedUnits = 32; //units above this aren't cached
+
+struct GLStateData
+{
+	GLuint program;
+	GLuint vertexArray;
+	GLuint arrayBuffer;
+	GLuint elementBuffer;
+	GLuint pixelUnpackBuffer;
+	GLuint pixelPackBuffer;
+	GLuint uniformBuffer;
+
+	unsigned int activeUnit;
+	GLuint textures[maxTrackedUnits];
+	GLuint samplers[maxTrackedUnits];
+
+	GLuint blend;
+	GLenum blendSource;
+	GLenum blendDestination;
+	GLuint depthTest;
+	GLuint depthMask;
+	GLenum depthFunc;
+
+	GLState::Stats stats;
+
+	GLStateData() { reset(); stats = {}; }
+
+	void reset()
+	{
+		program = vertexArray = unknown;
+		arrayBuffer = elementBuffer = pixelUnpackBuffer = pixelPackBuffer = uniformBuffer = unknown;
+		activeUnit = unknown;
+		for (unsigned int i = 0; i < maxTrackedUnits; i++)
+			textures[i] = samplers[i] = unknown;
+		blend = depthTest = depthMask = unknown;
+		blendSource = blendDestination = depthFunc = unknown;
+	}
+};
+
+static GLStateData gsData;
+
+//true when the call has to go through, updates the cached value
+static bool change(GLuint& cached, GLuint value)
+{
+	if (cached == value)
+	{
+		gsData.stats.skippedCount++;
+		return false;
+	}
+
+	cached = value;
+	gsData.stats.callCount++;
+	return true;
+}
+
+static GLuint* bufferSlot(GLenum target)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER:
+		return &gsData.arrayBuffer;
+	case GL_ELEMENT_ARRAY_BUFFER:
+		return &gsData.elementBuffer;
+	case GL_PIXEL_UNPACK_BUFFER:
+		return &gsData.pixelUnpackBuffer;
+	case GL_PIXEL_PACK_BUFFER:
+		return &gsData.pixelPackBuffer;
+	case GL_UNIFORM_BUFFER:
+		return &gsData.uniformBuffer;
+	default:
+		return nullptr;
+	}
+}
+
+static void setCapability(GLuint& cached, GLenum capability, bool enabled)
+{
+	if (!change(cached, enabled ? 1 : 0))
+		return;
+
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+}
+
+void GLState::useProgram(GLuint program)
+{
+	if (change(gsData.program, program))
+		glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vertexArray)
+{
+	if (change(gsData.vertexArray, vertexArray))
+	{
+		glBindVertexArray(vertexArray);
+		gsData.elementBuffer = unknown; //comes with the vertex array
+	}
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+	GLuint* cached = bufferSlot(target);
+	if (cached == nullptr)
+	{
+		gsData.stats.callCount++;
+		glBindBuffer(target, buffer);
+	}
+	else if (change(*cached, buffer))
+		glBindBuffer(target, buffer);
+}
+
+void GLState::activeTexture(unsigned int unit)
+{
+	if (change(gsData.activeUnit, unit))
+		glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::bindTexture(GLuint texture)
+{
+	if (gsData.activeUnit >= maxTrackedUnits) //unknown or untracked unit
+	{
+		gsData.stats.callCount++;
+		glBindTexture(GL_TEXTURE_2D, texture);
+	}
+	else if (change(gsData.textures[gsData.activeUnit], texture))
+		glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLState::bindTexture(unsigned int unit, GLuint texture)
+{
+	if (unit < maxTrackedUnits && gsData.textures[unit] == texture) //no need to switch units either
+	{
+		gsData.stats.skippedCount++;
+		return;
+	}
+
+	activeTexture(unit);
+	bindTexture(texture);
+}
+
+void GLState::bindSampler(unsigned int unit, GLuint sampler)
+{
+	if (unit >= maxTrackedUnits)
+	{
+		gsData.stats.callCount++;
+		glBindSampler(unit, sampler);
+	}
+	else if (change(gsData.samplers[unit], sampler))
+		glBindSampler(unit, sampler);
+}
+
+void GLState::setBlend(bool enabled)
+{
+	setCapability(gsData.blend, GL_BLEND, enabled);
+}
+
+void GLState::setBlendFunc(GLenum source, GLenum destination)
+{
+	if (gsData.blendSource == source && gsData.blendDestination == destination)
+	{
+		gsData.stats.skippedCount++;
+		return;
+	}
+
+	gsData.blendSource = source;
+	gsData.blendDestination = destination;
+	gsData.stats.callCount++;
+	glBlendFunc(source, destination);
+}
+
+void GLState::setDepthTest(bool enabled)
+{
+	setCapability(gsData.depthTest, GL_DEPTH_TEST, enabled);
+}
+
+void GLState::setDepthMask(bool enabled)
+{
+	if (change(gsData.depthMask, enabled ? 1 : 0))
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::setDepthFunc(GLenum func)
+{
+	if (change(gsData.depthFunc, func))
+		glDepthFunc(func);
+}
+
+void GLState::onProgramDeleted(GLuint program)
+{
+	if (gsData.program == program) //stays current until something else is used, just stop trusting it
+		gsData.program = unknown;
+}
+
+void GLState::onVertexArrayDeleted(GLuint vertexArray)
+{
+	if (gsData.vertexArray == vertexArray)
+	{
+		gsData.vertexArray = 0;
+		gsData.elementBuffer = unknown;
+	}
+}
+
+void GLState::onBufferDeleted(GLuint buffer)
+{
+	GLuint* buffers[] = { &gsData.arrayBuffer, &gsData.elementBuffer, &gsData.pixelUnpackBuffer, &gsData.pixelPackBuffer, &gsData.uniformBuffer };
+	for (GLuint* cached : buffers)
+		if (*cached == buffer)
+			*cached = 0;
+}
+
+void GLState::onTextureDeleted(GLuint texture)
+{
+	for (unsigned int i = 0; i < maxTrackedUnits; i++)
+		if (gsData.textures[i] == texture)
+			gsData.textures[i] = 0;
+}
+
+void GLState::onSamplerDeleted(GLuint sampler)
+{
+	for (unsigned int i = 0; i < maxTrackedUnits; i++)
+		if (gsData.samplers[i] == sampler)
+			gsData.samplers[i] = 0;
+}
+
+void GLState::invalidate()
+{
+	gsData.reset();
+}
+
+const GLState::Stats& GLState::getStats()
+{
+	return gsData.stats;
+}
+
+void GLState::resetStats()
+{
+	gsData.stats = {};
+}
@@ -0,0 +1,47 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+//shadow copy of the GL state the renderer touches, calls that wouldn't change anything never reach the driver
+//everything starts unknown so the first call always goes through, GL thread only (there's a single context)
+//code that changes this state with raw gl calls has to call invalidate() afterwards
+class GLState
+{
+public:
+	static void useProgram(GLuint program);
+	static void bindVertexArray(GLuint vertexArray);
+	static void bindBuffer(GLenum target, GLuint buffer); //the element array buffer is part of the vertex array
+
+	static void activeTexture(unsigned int unit);
+	static void bindTexture(GLuint texture); //GL_TEXTURE_2D on the active unit
+	static void bindTexture(unsigned int unit, GLuint texture);
+	static void bindSampler(unsigned int unit, GLuint sampler);
+
+	static void setBlend(bool enabled);
+	static void setBlendFunc(GLenum source, GLenum destination);
+	static void setDepthTest(bool enabled);
+	static void setDepthMask(bool enabled);
+	static void setDepthFunc(GLenum func);
+
+	//deleting an object unbinds it, call these right after the glDelete*
+	static void onProgramDeleted(GLuint program);
+	static void onVertexArrayDeleted(GLuint vertexArray);
+	static void onBufferDeleted(GLuint buffer);
+	static void onTextureDeleted(GLuint texture);
+	static void onSamplerDeleted(GLuint sampler);
+
+	static void invalidate(); //forget everything
+
+	//stats
+	struct Stats
+	{
+		unsigned int callCount; //state changes that went to the driver
+		unsigned int skippedCount; //redundant ones that didn't
+	};
+
+	static const Stats& getStats();
+	static void resetStats();
+};
+
+#endif
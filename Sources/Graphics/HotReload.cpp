@@ -0,0 +1,174 @@
+#include "HotReload.h"
+#include "TextureCache.h"
+#include "../Engine/FileWatcher.h"
+#include "../Engine/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+
+struct WatchedShader
+{
+	Shader* shader;
+	std::function<void(Shader&)> onReload;
+	std::string vertexPath; //normalized like the paths the watcher reports
+	std::string fragmentPath;
+};
+
+struct ReadShader //sources read on a worker, submitted to the driver on the GL thread
+{
+	Shader* shader;
+	bool success;
+	std::string vertexCode;
+	std::string fragmentCode;
+};
+
+struct HotReloadData
+{
+	FileWatcher watcher;
+	std::string projectPath; //texture names are relative to it
+	std::vector<WatchedShader> shaders;
+	std::vector<std::string> retryTextures; //names of textures that were loading when their file changed
+
+	std::mutex readMutex;
+	std::vector<ReadShader> read;
+	std::atomic<unsigned int> readingCount{ 0 };
+
+	HotReload::Stats stats = {};
+};
+
+static HotReloadData hrData;
+
+static std::string normalize(const std::string& path)
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+static void readShader(Shader* shader)
+{
+	hrData.readingCount++;
+	ThreadPool::getShared().enqueue([shader]()
+		{
+			ReadShader item;
+			item.shader = shader;
+			item.success = shader->readSources(item.vertexCode, item.fragmentCode);
+
+			{
+				std::lock_guard<std::mutex> lock(hrData.readMutex);
+				hrData.read.push_back(std::move(item));
+			}
+
+			hrData.readingCount--;
+		});
+}
+
+static void waitForReads()
+{
+	while (hrData.readingCount > 0) //the workers still use the shaders
+		ThreadPool::getShared().waitIdle();
+}
+
+bool HotReload::start(const char* assetDirectory)
+{
+	std::string projectPath = std::filesystem::current_path().string();
+	std::replace(projectPath.begin(), projectPath.end(), '\\', '/');
+	hrData.projectPath = normalize(projectPath);
+
+	return hrData.watcher.start(hrData.projectPath + assetDirectory);
+}
+
+void HotReload::addShader(Shader* shader, std::function<void(Shader&)> onReload)
+{
+	hrData.shaders.push_back({ shader, std::move(onReload), normalize(shader->getVertexPath()), normalize(shader->getFragmentPath()) });
+}
+
+void HotReload::removeShader(Shader* shader)
+{
+	waitForReads();
+
+	std::lock_guard<std::mutex> lock(hrData.readMutex);
+	hrData.read.erase(std::remove_if(hrData.read.begin(), hrData.read.end(), [shader](const ReadShader& item) { return item.shader == shader; }), hrData.read.end());
+	hrData.shaders.erase(std::remove_if(hrData.shaders.begin(), hrData.shaders.end(), [shader](const WatchedShader& watched) { return watched.shader == shader; }), hrData.shaders.end());
+}
+
+void HotReload::update()
+{
+	//switch to the programs the driver finished, never waits for the others
+	for (WatchedShader& watched : hrData.shaders)
+	{
+		Shader::RebuildStatus status = watched.shader->pollRebuild();
+		if (status == Shader::RebuildStatus::Switched)
+		{
+			if (watched.onReload)
+				watched.onReload(*watched.shader);
+			hrData.stats.shaderReloadCount++;
+		}
+		else if (status == Shader::RebuildStatus::Failed)
+			hrData.stats.shaderFailureCount++;
+	}
+
+	//submit the shaders whose files were read since the last frame
+	std::vector<ReadShader> read;
+	{
+		std::lock_guard<std::mutex> lock(hrData.readMutex);
+		read.swap(hrData.read);
+	}
+
+	for (ReadShader& item : read)
+	{
+		auto it = std::find_if(hrData.shaders.begin(), hrData.shaders.end(), [&item](const WatchedShader& watched) { return watched.shader == item.shader; });
+		if (it == hrData.shaders.end())
+			continue;
+
+		if (item.success)
+			item.shader->rebuild(item.vertexCode, item.fragmentCode);
+		else
+			hrData.stats.shaderFailureCount++;
+	}
+
+	if (!hrData.watcher.isWatching())
+		return;
+
+	std::vector<std::string> textures;
+	textures.swap(hrData.retryTextures);
+	std::vector<Shader*> shaders;
+	for (const std::string& path : hrData.watcher.poll())
+	{
+		for (const WatchedShader& watched : hrData.shaders)
+			if ((path == watched.vertexPath || path == watched.fragmentPath) && std::find(shaders.begin(), shaders.end(), watched.shader) == shaders.end())
+				shaders.push_back(watched.shader); //once even if both of its files changed
+
+		if (path.compare(0, hrData.projectPath.size(), hrData.projectPath) == 0)
+			textures.push_back(path.substr(hrData.projectPath.size())); //"/Assets/..." like the names textures were loaded with
+	}
+
+	for (Shader* shader : shaders)
+		readShader(shader);
+
+	for (const std::string& name : textures)
+	{
+		TextureHandle texture = TextureCache::get(name.c_str());
+		if (texture == nullptr) //not loaded or not a texture, it's read fresh whenever it gets loaded
+			continue;
+
+		if (texture->reload())
+			hrData.stats.textureReloadCount++;
+		else if (std::find(hrData.retryTextures.begin(), hrData.retryTextures.end(), name) == hrData.retryTextures.end())
+			hrData.retryTextures.push_back(name);
+	}
+}
+
+void HotReload::shutDown()
+{
+	waitForReads();
+
+	hrData.read.clear();
+	hrData.shaders.clear();
+	hrData.retryTextures.clear();
+	hrData.watcher.stop();
+}
+
+const HotReload::Stats& HotReload::getStats()
+{
+	return hrData.stats;
+}
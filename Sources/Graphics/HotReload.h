@@ -0,0 +1,32 @@
+#ifndef HOT_RELOAD_H
+#define HOT_RELOAD_H
+
+#include "Shader.h"
+#include <functional>
+
+//watches the asset directory and brings changed files into the running engine, no restart and no handles to swap:
+//cached textures are decoded again on the workers and re-uploaded into the same GL texture (a sub image upload when
+//the size and format didn't change), shaders read their files on the workers and switch programs only once the new
+//one linked (checked without waiting on the driver), so a typo leaves the old one running
+class HotReload
+{
+public:
+	static bool start(const char* assetDirectory); //like texture names, "/Assets" is under the working directory
+	//rebuilt when one of its files changes, onReload sets the uniforms again (the new program starts without them)
+	static void addShader(Shader* shader, std::function<void(Shader&)> onReload = nullptr);
+	static void removeShader(Shader* shader);
+	static void update(); //GL thread, once per frame before TextureLoader::update
+	static void shutDown(); //waits for the shader files being read
+
+	//stats
+	struct Stats
+	{
+		unsigned int textureReloadCount; //so far
+		unsigned int shaderReloadCount;
+		unsigned int shaderFailureCount; //edits that didn't compile or link
+	};
+
+	static const Stats& getStats();
+};
+
+#endif
@@ -0,0 +1,426 @@
+#include "ImageDecoder.h"
+#include "../Engine/MappedFile.h"
+#include "../Engine/ThreadPool.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_DECODER_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__) || defined(__AVX__)
+#define IMAGE_DECODER_SSSE3
+#include <tmmintrin.h>
+#endif
+
+static const unsigned char pngSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+static uint32_t readBigEndian(const unsigned char* data)
+{
+	return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+}
+
+//defiltering, bpp is bytes per pixel, prior is the previous row after defiltering (zeros for the first one)
+
+static void defilterUp(unsigned char* row, const unsigned char* prior, size_t rowBytes)
+{
+	size_t i = 0;
+#ifdef IMAGE_DECODER_SSE2
+	for (; i + 16 <= rowBytes; i += 16)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(row + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(prior + i));
+		_mm_storeu_si128((__m128i*)(row + i), _mm_add_epi8(x, b));
+	}
+#endif
+	for (; i < rowBytes; i++)
+		row[i] = (unsigned char)(row[i] + prior[i]);
+}
+
+static unsigned char paethPredictor(int a, int b, int c)
+{
+	int pa = abs(b - c);
+	int pb = abs(a - c);
+	int pc = abs(a + b - 2 * c);
+	if (pa <= pb && pa <= pc)
+		return (unsigned char)a;
+	return (unsigned char)(pb <= pc ? b : c);
+}
+
+static void defilterScalar(int filter, unsigned char* row, const unsigned char* prior, size_t rowBytes, int bpp)
+{
+	for (size_t i = 0; i < rowBytes; i++)
+	{
+		int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+		int c = i >= (size_t)bpp ? prior[i - bpp] : 0;
+		int b = prior[i];
+		switch (filter)
+		{
+		case 1: //sub
+			row[i] = (unsigned char)(row[i] + a);
+			break;
+		case 3: //average
+			row[i] = (unsigned char)(row[i] + ((a + b) >> 1));
+			break;
+		case 4: //paeth
+			row[i] = (unsigned char)(row[i] + paethPredictor(a, b, c));
+			break;
+		}
+	}
+}
+
+#ifdef IMAGE_DECODER_SSE2
+//sub, average and paeth depend on the pixel to the left, so pixels go one after another with all channels at once
+static __m128i loadPixel(const unsigned char* p, int bpp)
+{
+	int value = 0;
+	memcpy(&value, p, bpp);
+	return _mm_cvtsi32_si128(value);
+}
+
+static void storePixel(unsigned char* p, __m128i x, int bpp)
+{
+	int value = _mm_cvtsi128_si32(x);
+	memcpy(p, &value, bpp);
+}
+
+static void defilterSub(unsigned char* row, size_t rowBytes, int bpp)
+{
+	__m128i a = _mm_setzero_si128();
+	for (size_t i = 0; i < rowBytes; i += bpp)
+	{
+		a = _mm_add_epi8(a, loadPixel(row + i, bpp));
+		storePixel(row + i, a, bpp);
+	}
+}
+
+static void defilterAverage(unsigned char* row, const unsigned char* prior, size_t rowBytes, int bpp)
+{
+	const __m128i one = _mm_set1_epi8(1);
+	__m128i a = _mm_setzero_si128();
+	for (size_t i = 0; i < rowBytes; i += bpp)
+	{
+		__m128i b = loadPixel(prior + i, bpp);
+		__m128i average = _mm_avg_epu8(a, b); //rounds up, (a + b) >> 1 doesn't
+		average = _mm_sub_epi8(average, _mm_and_si128(_mm_xor_si128(a, b), one));
+		a = _mm_add_epi8(loadPixel(row + i, bpp), average);
+		storePixel(row + i, a, bpp);
+	}
+}
+
+static __m128i absolute16(__m128i x)
+{
+	return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static __m128i select(__m128i mask, __m128i ifTrue, __m128i ifFalse)
+{
+	return _mm_or_si128(_mm_and_si128(mask, ifTrue), _mm_andnot_si128(mask, ifFalse));
+}
+
+static void defilterPaeth(unsigned char* row, const unsigned char* prior, size_t rowBytes, int bpp)
+{
+	//16 bit lanes, the predictor distances go past 255
+	const __m128i zero = _mm_setzero_si128();
+	__m128i a = zero;
+	__m128i c = zero;
+	for (size_t i = 0; i < rowBytes; i += bpp)
+	{
+		__m128i b = _mm_unpacklo_epi8(loadPixel(prior + i, bpp), zero);
+		__m128i x = _mm_unpacklo_epi8(loadPixel(row + i, bpp), zero);
+
+		__m128i pa = _mm_sub_epi16(b, c); //p - a
+		__m128i pb = _mm_sub_epi16(a, c); //p - b
+		__m128i pc = absolute16(_mm_add_epi16(pa, pb)); //p - c
+		pa = absolute16(pa);
+		pb = absolute16(pb);
+
+		__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+		__m128i predicted = select(_mm_cmpeq_epi16(smallest, pa), a, select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+		a = _mm_add_epi8(x, predicted); //the high bytes are zero on both sides, so this wraps at 256 like png wants
+		c = b;
+		storePixel(row + i, _mm_packus_epi16(a, a), bpp);
+	}
+}
+#endif
+
+static bool defilterRow(int filter, unsigned char* row, const unsigned char* prior, size_t rowBytes, int bpp)
+{
+	switch (filter)
+	{
+	case 0:
+		return true;
+	case 2:
+		defilterUp(row, prior, rowBytes);
+		return true;
+	case 1:
+	case 3:
+	case 4:
+#ifdef IMAGE_DECODER_SSE2
+		if (bpp >= 3) //rgb and rgba, one pixel fits a register with room to spare
+		{
+			if (filter == 1)
+				defilterSub(row, rowBytes, bpp);
+			else if (filter == 3)
+				defilterAverage(row, prior, rowBytes, bpp);
+			else
+				defilterPaeth(row, prior, rowBytes, bpp);
+			return true;
+		}
+#endif
+		defilterScalar(filter, row, prior, rowBytes, bpp);
+		return true;
+	default:
+		return false;
+	}
+}
+
+//defiltered row to its flipped place in the output
+static void expandRGB(const unsigned char* source, unsigned char* target, int width)
+{
+	int i = 0;
+#ifdef IMAGE_DECODER_SSSE3
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	for (; i + 6 <= width; i += 4) //reads 16 bytes for 12, so stop while there are 2 more pixels
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(source + i * 3));
+		_mm_storeu_si128((__m128i*)(target + i * 4), _mm_or_si128(_mm_shuffle_epi8(x, shuffle), alpha));
+	}
+#endif
+	for (; i < width; i++)
+	{
+		target[i * 4 + 0] = source[i * 3 + 0];
+		target[i * 4 + 1] = source[i * 3 + 1];
+		target[i * 4 + 2] = source[i * 3 + 2];
+		target[i * 4 + 3] = 255;
+	}
+}
+
+//and of every alpha byte, 255 means the row is opaque
+static unsigned char rowAlpha(const unsigned char* row, size_t rowBytes, int channels)
+{
+	unsigned char alpha = 255;
+	size_t i = 0;
+#ifdef IMAGE_DECODER_SSE2
+	__m128i all = _mm_set1_epi8((char)0xFF);
+	for (; i + 16 <= rowBytes; i += 16)
+		all = _mm_and_si128(all, _mm_loadu_si128((const __m128i*)(row + i)));
+	alignas(16) unsigned char lanes[16];
+	_mm_store_si128((__m128i*)lanes, all);
+	for (int lane = channels - 1; lane < 16; lane += channels) //16 is a multiple of 2 and 4, lanes line up with pixels
+		alpha &= lanes[lane];
+#endif
+	for (i += channels - 1; i < rowBytes; i += channels)
+		alpha &= row[i];
+	return alpha;
+}
+
+//8 bit gray, gray + alpha, rgb and rgba without interlacing, false leaves it to stb
+static bool decodePng(const unsigned char* data, size_t size, ImageData& image)
+{
+	if (size < 8 + 25 || memcmp(data, pngSignature, 8) != 0)
+		return false;
+
+	int width = 0, height = 0, bpp = 0;
+	bool hasAlpha = false;
+	std::vector<unsigned char> compressed;
+	const unsigned char* idat = nullptr; //a single IDAT chunk is inflated straight from the file
+	size_t idatSize = 0;
+	int idatCount = 0;
+
+	size_t position = 8;
+	while (position + 12 <= size)
+	{
+		uint32_t length = readBigEndian(data + position);
+		const unsigned char* type = data + position + 4;
+		const unsigned char* chunk = data + position + 8;
+		if (length > size - position - 12)
+			return false;
+
+		if (memcmp(type, "IHDR", 4) == 0)
+		{
+			if (length < 13)
+				return false;
+			width = (int)readBigEndian(chunk);
+			height = (int)readBigEndian(chunk + 4);
+			int bitDepth = chunk[8];
+			int colorType = chunk[9];
+			int interlace = chunk[12];
+			static const int channels[7] = { 1, 0, 3, 0, 2, 0, 4 };
+			if (bitDepth != 8 || colorType > 6 || channels[colorType] == 0 || interlace != 0 || width <= 0 || height <= 0)
+				return false;
+			bpp = channels[colorType];
+			hasAlpha = colorType == 4 || colorType == 6;
+		}
+		else if (memcmp(type, "tRNS", 4) == 0) //color key transparency
+			return false;
+		else if (memcmp(type, "IDAT", 4) == 0)
+		{
+			if (idatCount == 1)
+				compressed.assign(idat, idat + idatSize);
+			if (idatCount >= 1)
+				compressed.insert(compressed.end(), chunk, chunk + length);
+			idat = chunk;
+			idatSize = length;
+			idatCount++;
+		}
+		else if (memcmp(type, "IEND", 4) == 0)
+			break;
+
+		position += 12 + length;
+	}
+
+	if (bpp == 0 || idatCount == 0 || (size_t)width * height > ((size_t)1 << 28))
+		return false;
+	if (idatCount > 1)
+	{
+		idat = compressed.data();
+		idatSize = compressed.size();
+	}
+
+	size_t rowBytes = (size_t)width * bpp;
+	size_t stride = rowBytes + 1; //filter type byte first
+	size_t filteredSize = stride * height;
+	std::unique_ptr<unsigned char[]> filtered(new unsigned char[filteredSize]);
+	if (stbi_zlib_decode_buffer((char*)filtered.get(), (int)filteredSize, (const char*)idat, (int)idatSize) != (int)filteredSize)
+		return false;
+
+	int channels = bpp == 3 ? 4 : bpp; //rgb is widened, drivers convert it on upload otherwise
+	size_t outputRowBytes = (size_t)width * channels;
+	unsigned char* pixels = (unsigned char*)malloc(outputRowBytes * height); //released by stbi_image_free (free) like stb's own
+	if (pixels == nullptr)
+		return false;
+
+	std::vector<unsigned char> zeros(rowBytes, 0);
+	const unsigned char* prior = zeros.data();
+	unsigned char alpha = 255;
+	for (int y = 0; y < height; y++)
+	{
+		unsigned char* row = filtered.get() + y * stride;
+		if (!defilterRow(row[0], row + 1, prior, rowBytes, bpp))
+		{
+			free(pixels);
+			return false;
+		}
+
+		unsigned char* target = pixels + (height - 1 - y) * outputRowBytes; //bottom row first, no flip pass afterwards
+		if (bpp == 3)
+			expandRGB(row + 1, target, width);
+		else
+		{
+			memcpy(target, row + 1, rowBytes);
+			if (hasAlpha)
+				alpha &= rowAlpha(row + 1, rowBytes, bpp);
+		}
+		prior = row + 1;
+	}
+
+	image.pixels = pixels;
+	image.width = width;
+	image.height = height;
+	image.numberOfChannels = channels;
+	image.isOpaque = alpha == 255;
+	return true;
+}
+
+bool ImageDecoder::decode(const unsigned char* data, size_t size, ImageData& image)
+{
+	if (!decodePng(data, size, image))
+	{
+		stbi_set_flip_vertically_on_load_thread(true); //flip images, per thread since workers decode concurrently
+		image.pixels = stbi_load_from_memory(data, (int)size, &image.width, &image.height, &image.numberOfChannels, 0);
+		if (!image.pixels)
+			return false;
+
+		image.isOpaque = true;
+		if (image.numberOfChannels == 2 || image.numberOfChannels == 4) //jpg has no alpha, png might still be fully opaque
+		{
+			size_t texelCount = (size_t)image.width * image.height;
+			for (size_t i = 0; i < texelCount && image.isOpaque; i++)
+				image.isOpaque = image.pixels[i * image.numberOfChannels + image.numberOfChannels - 1] == 255;
+		}
+	}
+
+	if (!image.isOpaque) //opaque images are premultiplied already
+		premultiply(image.pixels, (size_t)image.width * image.height, image.numberOfChannels);
+	return true;
+}
+
+//x * a / 255 rounded, exact for all 8 bit inputs
+static unsigned char multiplyAlpha(unsigned int x, unsigned int a)
+{
+	unsigned int t = x * a + 128;
+	return (unsigned char)((t + (t >> 8)) >> 8);
+}
+
+void ImageDecoder::premultiply(unsigned char* pixels, size_t texelCount, int numberOfChannels)
+{
+	if (numberOfChannels == 2)
+	{
+		for (size_t i = 0; i < texelCount; i++)
+			pixels[i * 2] = multiplyAlpha(pixels[i * 2], pixels[i * 2 + 1]);
+		return;
+	}
+	if (numberOfChannels != 4)
+		return;
+
+	size_t i = 0;
+#ifdef IMAGE_DECODER_SSE2
+	//4 texels at a time in 16 bit lanes, alpha is multiplied by 255 so the same rounding gives it back unchanged
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i colorMask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+	const __m128i alphaOne = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+	const __m128i half = _mm_set1_epi16(128);
+	for (; i + 4 <= texelCount; i += 4)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(pixels + i * 4));
+		__m128i halves[2] = { _mm_unpacklo_epi8(x, zero), _mm_unpackhi_epi8(x, zero) };
+		for (__m128i& texels : halves)
+		{
+			__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(texels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			alpha = _mm_or_si128(_mm_and_si128(alpha, colorMask), alphaOne);
+			__m128i t = _mm_add_epi16(_mm_mullo_epi16(texels, alpha), half);
+			texels = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+		}
+		_mm_storeu_si128((__m128i*)(pixels + i * 4), _mm_packus_epi16(halves[0], halves[1]));
+	}
+#endif
+	for (; i < texelCount; i++)
+	{
+		unsigned char* texel = pixels + i * 4;
+		texel[0] = multiplyAlpha(texel[0], texel[3]);
+		texel[1] = multiplyAlpha(texel[1], texel[3]);
+		texel[2] = multiplyAlpha(texel[2], texel[3]);
+	}
+}
+
+bool ImageDecoder::decode(const std::string& path, ImageData& image)
+{
+	MappedFile file;
+	if (!file.open(path))
+		return false;
+	return decode(file.getData(), file.getSize(), image);
+}
+
+unsigned int ImageDecoder::decodeBatch(const std::vector<std::string>& names, std::vector<ImageData>& images)
+{
+	images.clear();
+	images.resize(names.size());
+	std::vector<unsigned char> decoded(names.size(), 0);
+
+	ThreadPool::getShared().parallelFor(names.size(), [&](size_t i)
+		{
+			decoded[i] = Texture::decodeImage(names[i].c_str(), images[i]) ? 1 : 0;
+			if (!decoded[i])
+				Texture::freeImage(images[i]);
+		});
+
+	unsigned int count = 0;
+	for (unsigned char success : decoded)
+		count += success;
+	return count;
+}
@@ -0,0 +1,26 @@
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include "Texture.h"
+#include <string>
+#include <vector>
+
+//turns image files into pixels, rows bottom to top the way GL wants them
+//8 bit non-interlaced PNGs (the common case) go through a decoder of its own: stb's inflate, then SIMD defiltering
+//with the vertical flip, RGB to RGBA expansion and the opacity check done while writing each row out, so there's no
+//extra pass over the image, everything else (jpg, palettes, 16 bit...) still goes to stb_image
+class ImageDecoder
+{
+public:
+	//pixels, size, channels and isOpaque, no GL calls, colors come out premultiplied by alpha (no halos when filtered)
+	static bool decode(const std::string& path, ImageData& image);
+	static bool decode(const unsigned char* data, size_t size, ImageData& image);
+
+	static void premultiply(unsigned char* pixels, size_t texelCount, int numberOfChannels); //in place, 2 or 4 channels
+
+	//decodes (through Texture::decodeImage) on all the cores of the shared pool, returns how many succeeded
+	//images[i] belongs to names[i], failed ones have null pixels
+	static unsigned int decodeBatch(const std::vector<std::string>& names, std::vector<ImageData>& images);
+};
+
+#endif
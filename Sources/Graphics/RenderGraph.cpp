@@ -0,0 +1,285 @@
+#include "RenderGraph.h"
+#include "RenderTargetPool.h"
+#include <iostream>
+
+RenderGraph::ResourceHandle RenderGraph::createTexture(const std::string& name, const TextureDesc& desc)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc = desc;
+	resources.push_back(resource);
+	return (ResourceHandle)resources.size() - 1;
+}
+
+RenderGraph::ResourceHandle RenderGraph::importBackbuffer(const std::string& name, int width, int height)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc.width = width;
+	resource.desc.height = height;
+	resource.imported = true;
+	resources.push_back(resource);
+	return (ResourceHandle)resources.size() - 1;
+}
+
+void RenderGraph::addPass(const std::string& name, const std::vector<ResourceHandle>& reads, const std::vector<ResourceHandle>& writes, const ExecuteFunction& execute)
+{
+	Pass pass;
+	pass.name = name;
+	pass.reads = reads;
+	pass.writes = writes;
+	pass.execute = execute;
+	passes.push_back(pass);
+}
+
+void RenderGraph::compile()
+{
+	cullPasses();
+
+	executionOrder.clear();
+	for (int i = 0; i < (int)passes.size(); i++)
+		if (!passes[i].culled)
+			executionOrder.push_back(i);
+
+	//lifetimes in execution indices, culled passes don't extend them
+	for (Resource& resource : resources)
+	{
+		resource.firstUse = -1;
+		resource.lastUse = -1;
+	}
+	for (int i = 0; i < (int)executionOrder.size(); i++)
+	{
+		const Pass& pass = passes[executionOrder[i]];
+		for (const std::vector<ResourceHandle>* list : { &pass.reads, &pass.writes })
+			for (ResourceHandle handle : *list)
+			{
+				Resource& resource = resources[handle];
+				if (resource.firstUse < 0)
+					resource.firstUse = i;
+				resource.lastUse = i;
+			}
+	}
+
+	stats.transientTextureCount = 0;
+	for (const Resource& resource : resources)
+		if (!resource.imported && resource.firstUse >= 0)
+			stats.transientTextureCount++;
+	stats.physicalTextureCount = 0;
+	stats.passCount = (unsigned int)executionOrder.size();
+	stats.culledPassCount = (unsigned int)(passes.size() - executionOrder.size());
+}
+
+void RenderGraph::cullPasses()
+{
+	//walk backwards from the passes writing the backbuffer, a pass is needed if a needed pass reads something it writes
+	std::vector<bool> needed(resources.size(), false);
+	for (int i = (int)passes.size() - 1; i >= 0; i--)
+	{
+		Pass& pass = passes[i];
+		pass.culled = true;
+		for (ResourceHandle handle : pass.writes)
+			if (resources[handle].imported || needed[handle])
+				pass.culled = false;
+
+		if (pass.culled)
+			continue;
+
+		//reads before this pass come from earlier writers, which are now needed too
+		for (ResourceHandle handle : pass.writes)
+			if (!resources[handle].imported)
+				needed[handle] = false; //this write satisfies later readers, earlier writers are only needed if someone reads before it
+		for (ResourceHandle handle : pass.reads)
+			needed[handle] = true;
+	}
+}
+
+void RenderGraph::acquireTargets(int executionIndex)
+{
+	for (Resource& resource : resources)
+	{
+		if (resource.imported || resource.firstUse != executionIndex)
+			continue;
+
+		resource.target = RenderTargetPool::acquire(resource.desc);
+		bool reused = false; //a target released earlier this frame (aliased)
+		for (const Resource& other : resources)
+			if (&other != &resource && other.target == resource.target)
+				reused = true;
+		if (!reused)
+			stats.physicalTextureCount++;
+	}
+}
+
+void RenderGraph::releaseTargets(int executionIndex)
+{
+	for (Resource& resource : resources)
+	{
+		if (resource.imported || resource.lastUse != executionIndex)
+			continue;
+
+		RenderTargetPool::release(resource.target); //next resource with the same description takes it over
+	}
+}
+
+void RenderGraph::execute()
+{
+	readTimings();
+
+	for (int i = 0; i < (int)executionOrder.size(); i++)
+	{
+		Pass& pass = passes[executionOrder[i]];
+		acquireTargets(i);
+		bindTargets(pass);
+
+		PassQueries& queries = passQueries[pass.name];
+		int slot = frameIndex % queryLatency;
+		if (queries.queries[0] == 0)
+			glGenQueries(queryLatency, queries.queries);
+
+		glBeginQuery(GL_TIME_ELAPSED, queries.queries[slot]);
+		pass.execute(*this);
+		glEndQuery(GL_TIME_ELAPSED);
+		queries.issued[slot] = true;
+
+		for (ResourceHandle handle : pass.writes)
+			if (!resources[handle].imported)
+				resources[handle].target->resolve();
+		releaseTargets(i);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	frameIndex++;
+}
+
+void RenderGraph::bindTargets(const Pass& pass)
+{
+	std::vector<GLenum> drawBuffers;
+	bool backbuffer = false;
+	int width = 0, height = 0;
+
+	for (ResourceHandle handle : pass.writes)
+	{
+		const Resource& resource = resources[handle];
+		width = resource.desc.width;
+		height = resource.desc.height;
+		if (resource.imported)
+			backbuffer = true;
+	}
+
+	if (backbuffer || pass.writes.empty())
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	else if (pass.writes.size() == 1) //the target's own framebuffer
+		resources[pass.writes[0]].target->bind();
+	else
+	{
+		//several outputs, attach all of them to the graph's framebuffer
+		if (framebuffer == 0)
+		{
+			glGenFramebuffers(1, &framebuffer);
+			glGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &maxColorAttachments);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+		GLuint depthTexture = 0;
+		GLenum depthAttachment = GL_DEPTH_ATTACHMENT;
+		for (ResourceHandle handle : pass.writes)
+		{
+			const Resource& resource = resources[handle];
+			GLuint texture = resource.target->getTexture()->getGLTexture();
+			GLenum attachment = GL_COLOR_ATTACHMENT0 + (GLenum)drawBuffers.size();
+			if (RenderTarget::isDepthFormat(resource.desc.internalFormat))
+			{
+				depthTexture = texture;
+				depthAttachment = RenderTarget::getDepthAttachment(resource.desc.internalFormat);
+			}
+			else if (resource.target->getColorBuffer() != 0) //multisampled, drawn into the renderbuffer and resolved into the texture
+			{
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, resource.target->getColorBuffer());
+				drawBuffers.push_back(attachment);
+			}
+			else
+			{
+				glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, 0);
+				drawBuffers.push_back(attachment);
+			}
+		}
+
+		//detach leftovers of the previous pass
+		for (GLint i = (GLint)drawBuffers.size(); i < maxColorAttachments; i++)
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, 0, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0); //the previous pass might have had stencil
+		glFramebufferTexture2D(GL_FRAMEBUFFER, depthAttachment, GL_TEXTURE_2D, depthTexture, 0);
+
+		if (drawBuffers.empty())
+			glDrawBuffer(GL_NONE);
+		else
+			glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::RENDER_GRAPH::FRAMEBUFFER_INCOMPLETE (" << pass.name << ")" << std::endl;
+	}
+
+	if (width > 0 && height > 0)
+		glViewport(0, 0, width, height);
+}
+
+void RenderGraph::readTimings()
+{
+	//the slot about to be reused holds the oldest queries, read them only if the gpu is already done with them
+	int slot = frameIndex % queryLatency;
+	timings.clear();
+	for (int index : executionOrder)
+	{
+		const Pass& pass = passes[index];
+		auto it = passQueries.find(pass.name);
+		if (it == passQueries.end() || !it->second.issued[slot])
+			continue;
+
+		GLuint query = it->second.queries[slot];
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		timings.push_back({ pass.name, (double)elapsed / 1000000.0 });
+	}
+}
+
+void RenderGraph::clear()
+{
+	resources.clear();
+	passes.clear();
+	executionOrder.clear();
+}
+
+void RenderGraph::shutDown()
+{
+	for (auto& x : passQueries)
+		glDeleteQueries(queryLatency, x.second.queries);
+	passQueries.clear();
+
+	if (framebuffer != 0)
+		glDeleteFramebuffers(1, &framebuffer);
+	framebuffer = 0;
+
+	clear();
+}
+
+Texture* RenderGraph::getTexture(ResourceHandle resource) const
+{
+	if (resource < 0 || resource >= (ResourceHandle)resources.size() || resources[resource].target == nullptr)
+		return nullptr;
+	return resources[resource].target->getTexture();
+}
+
+const std::vector<RenderGraph::PassTiming>& RenderGraph::getTimings() const
+{
+	return timings;
+}
+
+const RenderGraph::Stats& RenderGraph::getStats() const
+{
+	return stats;
+}
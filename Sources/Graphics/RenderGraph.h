@@ -0,0 +1,104 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include "RenderTarget.h"
+
+//frame graph: passes declare the textures they read and write, the graph culls the passes that don't contribute to
+//the backbuffer and gets the transient textures from the RenderTargetPool right before their first use and gives
+//them back right after their last one, so textures with non overlapping lifetimes share the same render target
+//usage (every frame): clear() => create/import resources => addPass() => compile() => execute()
+class RenderGraph
+{
+public:
+	typedef int ResourceHandle;
+	static const ResourceHandle invalidResource = -1;
+
+	typedef RenderTarget::Desc TextureDesc;
+
+	struct PassTiming
+	{
+		std::string name;
+		double gpuMilliseconds; //from a few frames ago, queries are read back without stalling
+	};
+
+	typedef std::function<void(RenderGraph&)> ExecuteFunction;
+
+	//transient texture, only alive between its first and last use in the frame
+	ResourceHandle createTexture(const std::string& name, const TextureDesc& desc);
+	//the default framebuffer, passes writing to it are never culled
+	ResourceHandle importBackbuffer(const std::string& name, int width, int height);
+
+	//passes run in the order they are added, a read refers to the last write of the resource added before it
+	void addPass(const std::string& name, const std::vector<ResourceHandle>& reads, const std::vector<ResourceHandle>& writes, const ExecuteFunction& execute);
+
+	void compile();
+	void execute();
+	void clear(); //forget this frame's passes and resources, the allocated textures are kept for the next frames
+	void shutDown();
+
+	Texture* getTexture(ResourceHandle resource) const; //texture behind a transient resource, valid while a pass using it executes
+
+	const std::vector<PassTiming>& getTimings() const;
+
+	//stats
+	struct Stats
+	{
+		unsigned int passCount;
+		unsigned int culledPassCount;
+		unsigned int transientTextureCount; //resources declared this frame
+		unsigned int physicalTextureCount; //render targets actually used for them
+	};
+
+	const Stats& getStats() const;
+
+private:
+	static const int queryLatency = 3; //frames between issuing a timer query and reading it
+
+	struct Resource
+	{
+		std::string name;
+		TextureDesc desc;
+		bool imported = false;
+		int firstUse = -1; //execution index of the first/last pass using it
+		int lastUse = -1;
+		RenderTarget* target = nullptr; //while alive
+	};
+
+	struct Pass
+	{
+		std::string name;
+		std::vector<ResourceHandle> reads;
+		std::vector<ResourceHandle> writes;
+		ExecuteFunction execute;
+		bool culled = false;
+	};
+
+	struct PassQueries
+	{
+		GLuint queries[queryLatency] = {};
+		bool issued[queryLatency] = {};
+	};
+
+	std::vector<Resource> resources;
+	std::vector<Pass> passes;
+	std::vector<int> executionOrder; //indices of the passes that survived culling
+	std::map<std::string, PassQueries> passQueries;
+	std::vector<PassTiming> timings;
+	GLuint framebuffer = 0;
+	GLint maxColorAttachments = 0; //queried once, with the framebuffer
+	unsigned int frameIndex = 0;
+	Stats stats = {};
+
+	void cullPasses();
+	void acquireTargets(int executionIndex);
+	void releaseTargets(int executionIndex);
+	void bindTargets(const Pass& pass);
+	void readTimings();
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "RenderTarget.h"
+#include <iostream>
+
+bool RenderTarget::Desc::operator<(const Desc& other) const
+{
+	if (width != other.width)
+		return width < other.width;
+	if (height != other.height)
+		return height < other.height;
+	if (internalFormat != other.internalFormat)
+		return internalFormat < other.internalFormat;
+	if (samples != other.samples)
+		return samples < other.samples;
+	return depthBuffer < other.depthBuffer;
+}
+
+bool RenderTarget::Desc::operator==(const Desc& other) const
+{
+	return !(*this < other) && !(other < *this);
+}
+
+bool RenderTarget::isDepthFormat(GLenum internalFormat)
+{
+	return internalFormat == GL_DEPTH_COMPONENT16 || internalFormat == GL_DEPTH_COMPONENT24 || internalFormat == GL_DEPTH_COMPONENT32F
+		|| hasStencil(internalFormat);
+}
+
+bool RenderTarget::hasStencil(GLenum internalFormat)
+{
+	return internalFormat == GL_DEPTH24_STENCIL8 || internalFormat == GL_DEPTH32F_STENCIL8;
+}
+
+GLenum RenderTarget::getDepthAttachment(GLenum internalFormat)
+{
+	return hasStencil(internalFormat) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+}
+
+RenderTarget::RenderTarget(const Desc& desc) : desc(desc)
+{
+	texture = new Texture(desc.width, desc.height, desc.internalFormat);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+	if (isDepthFormat(desc.internalFormat)) //depth only
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, getDepthAttachment(desc.internalFormat), GL_TEXTURE_2D, texture->getGLTexture(), 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+	}
+	else if (desc.samples > 1)
+	{
+		glGenRenderbuffers(1, &colorBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, desc.samples, desc.internalFormat, desc.width, desc.height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+
+		if (desc.depthBuffer)
+		{
+			glGenRenderbuffers(1, &depthBuffer);
+			glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+			glRenderbufferStorageMultisample(GL_RENDERBUFFER, desc.samples, GL_DEPTH_COMPONENT24, desc.width, desc.height);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+		}
+
+		//the texture lives in its own framebuffer, resolve() blits into it
+		glGenFramebuffers(1, &resolveFramebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, resolveFramebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->getGLTexture(), 0);
+	}
+	else
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->getGLTexture(), 0);
+
+		if (desc.depthBuffer)
+		{
+			glGenRenderbuffers(1, &depthBuffer);
+			glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, desc.width, desc.height);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+		}
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::RENDER_TARGET::FRAMEBUFFER_INCOMPLETE" << std::endl;
+
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, desc.width, desc.height);
+}
+
+void RenderTarget::resolve()
+{
+	if (resolveFramebuffer == 0)
+		return;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFramebuffer);
+	glBlitFramebuffer(0, 0, desc.width, desc.height, 0, 0, desc.width, desc.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+Texture* RenderTarget::getTexture()
+{
+	return texture;
+}
+
+GLuint RenderTarget::getFramebuffer() const
+{
+	return framebuffer;
+}
+
+GLuint RenderTarget::getColorBuffer() const
+{
+	return colorBuffer;
+}
+
+RenderTarget::~RenderTarget()
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	if (resolveFramebuffer != 0)
+		glDeleteFramebuffers(1, &resolveFramebuffer);
+	if (colorBuffer != 0)
+		glDeleteRenderbuffers(1, &colorBuffer);
+	if (depthBuffer != 0)
+		glDeleteRenderbuffers(1, &depthBuffer);
+
+	delete texture;
+}
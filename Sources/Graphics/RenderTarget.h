@@ -0,0 +1,47 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <glad/glad.h>
+#include "Texture.h"
+
+//framebuffer with a texture to render into, get them from the RenderTargetPool instead of creating them every frame
+class RenderTarget
+{
+public:
+	struct Desc
+	{
+		int width;
+		int height;
+		GLenum internalFormat = GL_RGBA8; //depth (and depth stencil) formats make a depth only target (the texture is the depth attachment)
+		int samples = 1; //more than 1 renders into multisampled renderbuffers, resolve() copies them into the texture
+		bool depthBuffer = true; //adds a depth renderbuffer (color targets only)
+
+		bool operator<(const Desc& other) const;
+		bool operator==(const Desc& other) const;
+	};
+
+	const Desc desc;
+
+	RenderTarget(const Desc& desc);
+	RenderTarget(const RenderTarget&) = delete;
+	RenderTarget& operator=(const RenderTarget&) = delete;
+	~RenderTarget();
+
+	void bind(); //binds the framebuffer and sets the viewport to its size
+	void resolve(); //multisampled targets only, call before sampling the texture
+	Texture* getTexture();
+	GLuint getFramebuffer() const;
+	GLuint getColorBuffer() const; //the multisampled renderbuffer drawn into, 0 when the texture is drawn into directly
+
+	static bool isDepthFormat(GLenum internalFormat); //stencil formats included
+	static bool hasStencil(GLenum internalFormat);
+	static GLenum getDepthAttachment(GLenum internalFormat); //GL_DEPTH_STENCIL_ATTACHMENT for stencil formats
+private:
+	GLuint framebuffer = 0;
+	GLuint colorBuffer = 0; //multisampled color renderbuffer
+	GLuint depthBuffer = 0; //depth renderbuffer
+	GLuint resolveFramebuffer = 0; //multisampled only, has the texture attached
+	Texture* texture = nullptr;
+};
+
+#endif
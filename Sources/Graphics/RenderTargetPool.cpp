@@ -0,0 +1,79 @@
+#include "RenderTargetPool.h"
+#include <map>
+
+static const unsigned int maxUnusedFrames = 60; //free targets older than this are deleted
+
+struct PooledTarget
+{
+	RenderTarget* target;
+	unsigned int releasedFrame;
+};
+
+struct PoolData
+{
+	std::multimap<RenderTarget::Desc, PooledTarget> freeTargets;
+	unsigned int frameIndex = 0;
+	RenderTargetPool::Stats stats = {};
+};
+
+static PoolData pData;
+
+RenderTarget* RenderTargetPool::acquire(const RenderTarget::Desc& desc)
+{
+	pData.stats.acquireCount++;
+	pData.stats.liveCount++;
+
+	auto it = pData.freeTargets.find(desc);
+	if (it != pData.freeTargets.end())
+	{
+		RenderTarget* target = it->second.target;
+		pData.freeTargets.erase(it);
+		pData.stats.pooledCount--;
+		return target;
+	}
+
+	pData.stats.createCount++;
+	return new RenderTarget(desc);
+}
+
+void RenderTargetPool::release(RenderTarget* target)
+{
+	if (target == nullptr)
+		return;
+
+	pData.freeTargets.insert({ target->desc, { target, pData.frameIndex } });
+	pData.stats.pooledCount++;
+	pData.stats.liveCount--;
+}
+
+void RenderTargetPool::endFrame()
+{
+	for (auto it = pData.freeTargets.begin(); it != pData.freeTargets.end();)
+	{
+		if (pData.frameIndex - it->second.releasedFrame > maxUnusedFrames)
+		{
+			delete it->second.target;
+			it = pData.freeTargets.erase(it);
+			pData.stats.pooledCount--;
+		}
+		else
+			it++;
+	}
+
+	pData.frameIndex++;
+	pData.stats.acquireCount = 0;
+	pData.stats.createCount = 0;
+}
+
+void RenderTargetPool::shutDown()
+{
+	for (auto& x : pData.freeTargets)
+		delete x.second.target;
+	pData.freeTargets.clear();
+	pData.stats.pooledCount = 0;
+}
+
+const RenderTargetPool::Stats& RenderTargetPool::getStats()
+{
+	return pData.stats;
+}
@@ -0,0 +1,28 @@
+#ifndef RENDER_TARGET_POOL_H
+#define RENDER_TARGET_POOL_H
+
+#include "RenderTarget.h"
+
+//keeps released render targets around (keyed by size, format and samples) so the next acquire with the same
+//description reuses them instead of allocating a new framebuffer and textures
+class RenderTargetPool
+{
+public:
+	static RenderTarget* acquire(const RenderTarget::Desc& desc);
+	static void release(RenderTarget* target); //the target can be handed out again right away
+	static void endFrame(); //call once per frame, deletes targets nobody acquired for a while
+	static void shutDown();
+
+	//stats
+	struct Stats
+	{
+		unsigned int acquireCount; //this frame
+		unsigned int createCount; //this frame, acquires that had to allocate
+		unsigned int pooledCount; //free targets waiting to be reused
+		unsigned int liveCount; //acquired and not released yet
+	};
+
+	static const Stats& getStats();
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "RenderThread.h"
+#include "../Engine/SPSCQueue.h"
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+static const size_t queueCapacity = 1024;
+static const int spinsBeforeSleep = 64; //idle render thread yields for a while, then sleeps a little between checks
+
+struct RenderThreadData
+{
+	GLFWwindow* window = nullptr;
+	bool enabled = false;
+	int maxFramesInFlight = 1;
+
+	std::thread thread;
+	std::thread::id renderThreadID;
+	std::thread::id producerThreadID; //the only thread that may push into the queue (the one that called start)
+	std::atomic<bool> running{ false };
+	std::atomic<int> framesInFlight{ 0 }; //frames whose swap command hasn't run yet
+	SPSCQueue<RenderThread::Command, queueCapacity> queue;
+
+	RenderThread::Stats frameStats = {}; //being filled this frame
+	RenderThread::Stats stats = {}; //last complete frame
+};
+
+static RenderThreadData tData;
+
+static void renderLoop()
+{
+	glfwMakeContextCurrent(tData.window);
+
+	RenderThread::Command command;
+	int idleSpins = 0;
+	while (true)
+	{
+		if (tData.queue.pop(command))
+		{
+			command();
+			command = nullptr;
+			idleSpins = 0;
+			continue;
+		}
+
+		if (!tData.running.load(std::memory_order_acquire)) //only stop once the queue is drained
+			break;
+
+		if (++idleSpins < spinsBeforeSleep)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	glfwMakeContextCurrent(nullptr);
+}
+
+void RenderThread::start(GLFWwindow* window, bool enabled, int maxFramesInFlight)
+{
+	tData.window = window;
+	tData.enabled = enabled;
+	tData.maxFramesInFlight = maxFramesInFlight < 1 ? 1 : maxFramesInFlight;
+	tData.renderThreadID = std::this_thread::get_id();
+	tData.producerThreadID = std::this_thread::get_id();
+
+	if (!enabled)
+		return;
+
+	glfwMakeContextCurrent(nullptr); //a context can only be current on one thread
+	tData.running = true;
+	tData.thread = std::thread(renderLoop);
+	tData.renderThreadID = tData.thread.get_id();
+}
+
+void RenderThread::stop()
+{
+	if (!tData.enabled)
+		return;
+
+	tData.running.store(false, std::memory_order_release);
+	tData.thread.join();
+	tData.enabled = false;
+	tData.framesInFlight = 0;
+
+	glfwMakeContextCurrent(tData.window);
+	tData.renderThreadID = std::this_thread::get_id();
+}
+
+void RenderThread::submit(Command command)
+{
+	if (tData.enabled && isRenderThread()) //a command recording more work, it can't wait on the queue only it drains
+	{
+		command();
+		return;
+	}
+
+	//single producer: the queue and the stats are only safe from the thread that started the render thread
+	assert(std::this_thread::get_id() == tData.producerThreadID);
+
+	tData.frameStats.commandCount++;
+	if (!tData.enabled)
+	{
+		command();
+		return;
+	}
+
+	if (tData.queue.push(std::move(command)))
+		return;
+
+	tData.frameStats.queueFullWaits++;
+	while (!tData.queue.push(std::move(command))) //a failed push leaves the command untouched
+		std::this_thread::yield();
+}
+
+void RenderThread::endFrame()
+{
+	if (!tData.enabled)
+		glfwSwapBuffers(tData.window);
+	else
+	{
+		tData.framesInFlight.fetch_add(1, std::memory_order_relaxed);
+		submit([]()
+			{
+				glfwSwapBuffers(tData.window);
+				tData.framesInFlight.fetch_sub(1, std::memory_order_release);
+			});
+
+		auto waitStart = std::chrono::high_resolution_clock::now();
+		while (tData.framesInFlight.load(std::memory_order_acquire) > tData.maxFramesInFlight)
+			std::this_thread::yield();
+		tData.frameStats.frameWaitMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - waitStart).count();
+	}
+
+	tData.stats = tData.frameStats;
+	tData.frameStats = {};
+}
+
+void RenderThread::waitIdle()
+{
+	if (!tData.enabled)
+		return;
+
+	std::atomic<bool> done{ false };
+	submit([&done]() { done.store(true, std::memory_order_release); });
+	while (!done.load(std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
+bool RenderThread::isEnabled()
+{
+	return tData.enabled;
+}
+
+bool RenderThread::isRenderThread()
+{
+	return std::this_thread::get_id() == tData.renderThreadID;
+}
+
+const RenderThread::Stats& RenderThread::getStats()
+{
+	return tData.stats;
+}
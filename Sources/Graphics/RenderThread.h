@@ -0,0 +1,44 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <functional>
+
+struct GLFWwindow;
+
+//optional thread owning the GL context, the game thread records commands (closures doing the GL work) and the render
+//thread runs them, so simulating frame N+1 overlaps submitting frame N
+//when it isn't enabled, commands run right away on the calling thread, callers don't have to care which mode is on
+class RenderThread
+{
+public:
+	typedef std::function<void()> Command;
+
+	//takes the context of the window away from the calling thread if enabled
+	//maxFramesInFlight bounds how far the game thread can get ahead of the gpu submission (latency)
+	static void start(GLFWwindow* window, bool enabled, int maxFramesInFlight = 1);
+	//runs everything still queued, joins the thread and makes the context current on the calling thread again
+	static void stop();
+
+	//the queue has a single producer: call it only from the thread that called start (the game thread), or from the
+	//render thread itself, where the command runs right away, other threads have to hand their work to one of those
+	static void submit(Command command);
+	//queues the buffer swap and blocks while more than maxFramesInFlight frames are waiting to be rendered
+	static void endFrame();
+	//blocks until every command submitted so far ran (sync point for reading back GL state)
+	static void waitIdle();
+
+	static bool isEnabled();
+	static bool isRenderThread(); //true on the thread that owns the context (the caller itself when disabled)
+
+	//stats
+	struct Stats
+	{
+		unsigned int commandCount; //submitted this frame
+		unsigned int queueFullWaits; //submits that had to wait for room in the queue this frame
+		double frameWaitMilliseconds; //time the game thread spent blocked in endFrame last frame
+	};
+
+	static const Stats& getStats();
+};
+
+#endif
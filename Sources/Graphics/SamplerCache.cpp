@@ -0,0 +1,71 @@
+#include "SamplerCache.h"
+#include "GLState.h"
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+struct SamplerCacheData
+{
+	std::map<SamplerDesc, GLuint> samplers;
+	float maxAnisotropy = 0.0f; //queried on first use
+	SamplerCache::Stats stats = {};
+};
+
+static SamplerCacheData scData;
+
+bool SamplerDesc::operator<(const SamplerDesc& other) const
+{
+	return std::tie(wrapS, wrapT, minFilter, magFilter, anisotropy) < std::tie(other.wrapS, other.wrapT, other.minFilter, other.magFilter, other.anisotropy);
+}
+
+bool SamplerDesc::operator==(const SamplerDesc& other) const
+{
+	return wrapS == other.wrapS && wrapT == other.wrapT && minFilter == other.minFilter && magFilter == other.magFilter && anisotropy == other.anisotropy;
+}
+
+GLuint SamplerCache::get(const SamplerDesc& desc)
+{
+	auto it = scData.samplers.find(desc);
+	if (it != scData.samplers.end())
+		return it->second;
+
+	GLuint sampler;
+	glGenSamplers(1, &sampler);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, desc.wrapS);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, desc.wrapT);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, desc.minFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, desc.magFilter);
+	if (desc.anisotropy > 1.0f && GLAD_GL_EXT_texture_filter_anisotropic)
+		glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(desc.anisotropy, getMaxAnisotropy()));
+
+	scData.samplers[desc] = sampler;
+	scData.stats.samplerCount++;
+	return sampler;
+}
+
+float SamplerCache::getMaxAnisotropy()
+{
+	if (scData.maxAnisotropy == 0.0f)
+	{
+		scData.maxAnisotropy = 1.0f;
+		if (GLAD_GL_EXT_texture_filter_anisotropic)
+			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &scData.maxAnisotropy);
+	}
+	return scData.maxAnisotropy;
+}
+
+void SamplerCache::shutDown()
+{
+	for (auto& entry : scData.samplers)
+	{
+		glDeleteSamplers(1, &entry.second);
+		GLState::onSamplerDeleted(entry.second);
+	}
+	scData.samplers.clear();
+	scData.stats = {};
+}
+
+const SamplerCache::Stats& SamplerCache::getStats()
+{
+	return scData.stats;
+}
@@ -0,0 +1,36 @@
+#ifndef SAMPLER_CACHE_H
+#define SAMPLER_CACHE_H
+
+#include <glad/glad.h>
+
+//how a texture is sampled, kept apart from the texture object so one image can be read with different settings
+struct SamplerDesc
+{
+	GLint wrapS = GL_CLAMP_TO_EDGE;
+	GLint wrapT = GL_CLAMP_TO_EDGE;
+	GLint minFilter = GL_NEAREST;
+	GLint magFilter = GL_NEAREST;
+	float anisotropy = 1.0f; //1 is off, clamped to what the gpu supports
+
+	bool operator<(const SamplerDesc& other) const;
+	bool operator==(const SamplerDesc& other) const;
+};
+
+//one sampler object per distinct description, created on first use and shared by everything sampling with it
+class SamplerCache
+{
+public:
+	static GLuint get(const SamplerDesc& desc); //GL thread
+	static float getMaxAnisotropy(); //1 without GL_EXT_texture_filter_anisotropic
+	static void shutDown();
+
+	//stats
+	struct Stats
+	{
+		unsigned int samplerCount;
+	};
+
+	static const Stats& getStats();
+};
+
+#endif
@@ -1,127 +1,411 @@
 #include "Shader.h"
+#include "GLState.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cassert>
 
-Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath)
+// reads a whole file, false (and an empty string) when it can't be opened
+static bool readFile(const std::string& path, std::string& code)
 {
-    // 1. retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
+    std::ifstream file;
     // ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     try
     {
-        // open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        // convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        file.open(path);
+        std::stringstream stream;
+        // read file's buffer contents into the stream
+        stream << file.rdbuf();
+        file.close();
+        code = stream.str();
+        return true;
     }
-    catch (std::ifstream::failure e)
+    catch (const std::ifstream::failure&)
     {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+        code.clear();
+        return false;
     }
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+}
 
-    // 2. compile shaders
-    unsigned int vertex, fragment;
-    int success;
+// the stages are only submitted, their status is read in finishBuild
+static unsigned int compileStage(GLenum type, const char* code)
+{
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &code, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+static bool checkStage(unsigned int shader, const char* stageName)
+{
+    int status;
     char infoLog[512];
 
-    // vertex Shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
     // print compile errors if any
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success)
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status)
     {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    };
-
-    //fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    // print compile errors if any
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    };
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::" << stageName << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+    return status != 0;
+}
+
+// compiles and links without asking the driver how it went, so it can keep working (on its own threads with
+// KHR_parallel_shader_compile) while more programs are submitted
+static Shader::Build submitBuild(const std::string& vertexCode, const std::string& fragmentCode)
+{
+    Shader::Build build = {};
+
+    // linked on an earlier run
+    build.cacheKey = ShaderCache::getKey(vertexCode, fragmentCode);
+    build.program = ShaderCache::load(build.cacheKey);
+    if (build.program != 0)
+        return build;
+
+    build.vertex = compileStage(GL_VERTEX_SHADER, vertexCode.c_str());
+    build.fragment = compileStage(GL_FRAGMENT_SHADER, fragmentCode.c_str());
 
     // shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
+    build.program = glCreateProgram();
+    glAttachShader(build.program, build.vertex);
+    glAttachShader(build.program, build.fragment);
+    ShaderCache::prepare(build.program);
+    glLinkProgram(build.program);
+    return build;
+}
+
+// never waits with the extension, without it asking would wait anyway so the build counts as complete
+static bool isBuildComplete(const Shader::Build& build)
+{
+    if (!GLAD_GL_KHR_parallel_shader_compile || build.vertex == 0)
+        return true;
+
+    int complete;
+    glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete != 0;
+}
+
+// waits for the build if it isn't complete, prints the errors and stores the binary of a good one
+static bool finishBuild(Shader::Build& build)
+{
+    if (build.vertex == 0) // from the cache, linked already
+        return true;
+
+    bool success = checkStage(build.vertex, "VERTEX");
+    success = checkStage(build.fragment, "FRAGMENT") && success;
+
     // print linking errors if any
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
-    if (!success)
+    int status;
+    char infoLog[512];
+    glGetProgramiv(build.program, GL_LINK_STATUS, &status);
+    if (!status)
     {
-        glGetProgramInfoLog(ID, 512, NULL, infoLog);
+        glGetProgramInfoLog(build.program, 512, NULL, infoLog);
         std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        success = false;
     }
 
     // delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    glDeleteShader(build.vertex);
+    glDeleteShader(build.fragment);
+    build.vertex = build.fragment = 0;
+
+    if (success)
+        ShaderCache::store(build.cacheKey, build.program);
+    return success;
+}
+
+// for builds nobody will use, their errors don't matter
+static void deleteStages(Shader::Build& build)
+{
+    if (build.vertex == 0)
+        return;
+    glDeleteShader(build.vertex);
+    glDeleteShader(build.fragment);
+    build.vertex = build.fragment = 0;
+}
+
+static void discardBuild(Shader::Build& build)
+{
+    deleteStages(build);
+    glDeleteProgram(build.program);
+    build = {};
+}
+
+void Shader::setCompilerThreads(unsigned int count)
+{
+    if (GLAD_GL_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(count);
+}
+
+Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath)
+{
+    // 1. retrieve the vertex/fragment source code from filePath
+    std::string vertexCode;
+    std::string fragmentCode;
+    readFile(vertexPath, vertexCode);
+    readFile(fragmentPath, fragmentCode);
+
+    // 2. compile shaders, checked on first use
+    build = submitBuild(vertexCode, fragmentCode);
+    ID = build.program;
+    isBuildPending = true;
+}
+
+bool Shader::isReady() const
+{
+    return !isBuildPending || isBuildComplete(build);
+}
+
+void Shader::finishPendingBuild()
+{
+    isBuildPending = false;
+    finishBuild(build); // a failed program stays, drawing with it does nothing
+    buildUniformTable();
+}
+
+void Shader::rebuild(const std::string& vertexCode, const std::string& fragmentCode)
+{
+    if (isRebuildPending) // superseded
+        discardBuild(rebuildBuild);
+
+    rebuildBuild = submitBuild(vertexCode, fragmentCode);
+    isRebuildPending = true;
+}
+
+Shader::RebuildStatus Shader::completeRebuild(bool wait)
+{
+    if (!isRebuildPending)
+        return RebuildStatus::None;
+    if (!wait && !isBuildComplete(rebuildBuild))
+        return RebuildStatus::Pending;
+
+    isRebuildPending = false;
+    if (!finishBuild(rebuildBuild)) // keep drawing with the old one
+    {
+        glDeleteProgram(rebuildBuild.program);
+        rebuildBuild = {};
+        return RebuildStatus::Failed;
+    }
+
+    if (isBuildPending) // replaced before it was ever used
+    {
+        isBuildPending = false;
+        deleteStages(build);
+    }
+
+    deleteShader();
+    ID = rebuildBuild.program;
+    rebuildBuild = {};
+    buildUniformTable(); // the handles handed out so far point at the new locations
+    return RebuildStatus::Switched;
+}
+
+Shader::RebuildStatus Shader::pollRebuild()
+{
+    return completeRebuild(false);
+}
+
+bool Shader::reload()
+{
+    std::string vertexCode;
+    std::string fragmentCode;
+    if (!readFile(vertexPath, vertexCode) || !readFile(fragmentPath, fragmentCode))
+        return false;
+
+    rebuild(vertexCode, fragmentCode);
+    return completeRebuild(true) == RebuildStatus::Switched;
+}
+
+bool Shader::readSources(std::string& vertexCode, std::string& fragmentCode) const
+{
+    return readFile(vertexPath, vertexCode) && readFile(fragmentPath, fragmentCode);
+}
+
+const std::string& Shader::getVertexPath() const
+{
+    return vertexPath;
+}
+
+const std::string& Shader::getFragmentPath() const
+{
+    return fragmentPath;
 }
 
 void Shader::use()
 {
-    glUseProgram(ID);
+    if (isBuildPending)
+        finishPendingBuild();
+    GLState::useProgram(ID); //skipped when it's current already
+}
+
+static uint64_t hashName(const char* name) // FNV-1a
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (; *name != '\0'; name++)
+    {
+        hash ^= (unsigned char)*name;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void Shader::addUniform(const std::string& name, int location)
+{
+    uint64_t key = hashName(name.c_str());
+    auto it = uniformLocations.find(key);
+    if (it != uniformLocations.end() && it->second != location)
+    {
+        std::cout << "ERROR::SHADER::UNIFORM_HASH_COLLISION " << name << std::endl;
+        return;
+    }
+    uniformLocations[key] = location;
+}
+
+void Shader::buildUniformTable()
+{
+    uniformLocations.clear();
+
+    // the driver is asked once per uniform here instead of on every set
+    int uniformCount = 0;
+    int maxNameLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+    for (int i = 0; i < uniformCount; i++)
+    {
+        GLsizei length;
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+        std::string name(nameBuffer.data(), length);
+
+        int location = glGetUniformLocation(ID, name.c_str());
+        if (location < 0) // in a uniform block
+            continue;
+
+        // arrays come back as "name[0]", they're set through "name" as well as element by element
+        size_t bracket = name.find('[');
+        if (bracket == std::string::npos)
+        {
+            addUniform(name, location);
+            continue;
+        }
+
+        std::string baseName = name.substr(0, bracket);
+        addUniform(baseName, location);
+        for (int element = 0; element < size; element++)
+        {
+            std::string elementName = baseName + "[" + std::to_string(element) + "]";
+            addUniform(elementName, element == 0 ? location : glGetUniformLocation(ID, elementName.c_str()));
+        }
+    }
+
+    for (size_t i = 0; i < handleNames.size(); i++)
+        handleLocations[i] = getUniformLocation(handleNames[i].c_str());
+}
+
+int Shader::getUniformLocation(const char* name) const
+{
+    assert(!isBuildPending && "use() or getUniform() first, the table is built when the pending build finishes");
+    auto it = uniformLocations.find(hashName(name));
+    return it != uniformLocations.end() ? it->second : -1; // -1 makes glUniform* do nothing, like the driver's lookup
+}
+
+UniformHandle Shader::getUniform(const char* name)
+{
+    if (isBuildPending)
+        finishPendingBuild();
+
+    for (size_t i = 0; i < handleNames.size(); i++)
+        if (handleNames[i] == name)
+            return { (int)i };
+
+    handleNames.push_back(name);
+    handleLocations.push_back(getUniformLocation(name));
+    return { (int)handleNames.size() - 1 };
+}
+
+int Shader::getLocation(UniformHandle uniform) const
+{
+    return uniform.index >= 0 ? handleLocations[uniform.index] : -1;
 }
 
 void Shader::setBool(const char* name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name), (int)value);
+    glUniform1i(getUniformLocation(name), (int)value);
 }
 
 void Shader::setInt(const char* name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name), value);
+    glUniform1i(getUniformLocation(name), value);
 }
 
 void Shader::setFloat(const char* name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name), value);
+    glUniform1f(getUniformLocation(name), value);
 }
 
 void Shader::setVecf(const char* name, uint32_t count, const GLfloat* value) const
 {
-    glUniform1fv(glGetUniformLocation(ID, name), count, value);
+    glUniform1fv(getUniformLocation(name), count, value);
 }
 
 void Shader::setVeci(const char* name, uint32_t count, const GLint* value) const
 {
-    glUniform1iv(glGetUniformLocation(ID, name), count, value);
+    glUniform1iv(getUniformLocation(name), count, value);
 }
 
 void Shader::setMat4(const char* name, int count, const GLfloat* value) const
 {
-    unsigned int transformLoc = glGetUniformLocation(ID, name);
-    glUniformMatrix4fv(transformLoc, count, GL_FALSE, value);
+    glUniformMatrix4fv(getUniformLocation(name), count, GL_FALSE, value);
+}
+
+void Shader::setBool(UniformHandle uniform, bool value) const
+{
+    glUniform1i(getLocation(uniform), (int)value);
+}
+
+void Shader::setInt(UniformHandle uniform, int value) const
+{
+    glUniform1i(getLocation(uniform), value);
+}
+
+void Shader::setFloat(UniformHandle uniform, float value) const
+{
+    glUniform1f(getLocation(uniform), value);
+}
+
+void Shader::setVecf(UniformHandle uniform, uint32_t count, const GLfloat* value) const
+{
+    glUniform1fv(getLocation(uniform), count, value);
+}
+
+void Shader::setVeci(UniformHandle uniform, uint32_t count, const GLint* value) const
+{
+    glUniform1iv(getLocation(uniform), count, value);
+}
+
+void Shader::setMat4(UniformHandle uniform, int count, const GLfloat* value) const
+{
+    glUniformMatrix4fv(getLocation(uniform), count, GL_FALSE, value);
 }
 
 void Shader::deleteShader() const
 {
     glDeleteProgram(ID);
+    GLState::onProgramDeleted(ID);
 }
 
 Shader::~Shader()
 {
+    if (isBuildPending)
+        deleteStages(build);
+    if (isRebuildPending)
+        discardBuild(rebuildBuild);
     deleteShader();
 }
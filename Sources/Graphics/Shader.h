@@ -3,31 +3,102 @@
 
 #include <glad/glad.h> // include glad to get all the required OpenGL headers
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <glm/glm.hpp>
 
+// a uniform resolved once by name, setting it is an index into the shader's table and the glUniform* call
+// stays valid when the program is rebuilt, names the program doesn't use give a handle that sets nothing
+struct UniformHandle
+{
+    int index = -1;
+};
+
 class Shader
 {
 public:
     // the program ID
     unsigned int ID;
 
-    // constructor reads and builds the shader
+    // a program submitted to the driver whose status hasn't been read yet
+    struct Build
+    {
+        unsigned int program;
+        unsigned int vertex; // 0 once finished, or when the program came from the cache
+        unsigned int fragment;
+        uint64_t cacheKey;
+    };
+
+    enum class RebuildStatus
+    {
+        None,
+        Pending,
+        Switched, // the new program is in use, its uniforms have to be set again
+        Failed // didn't compile or link, the old program stays
+    };
+
+    // how many threads the driver may compile on (KHR_parallel_shader_compile), call it before creating shaders,
+    // 0xFFFFFFFF lets the driver decide
+    static void setCompilerThreads(unsigned int count);
+
+    // constructor reads the shader and submits its build, construct all of them before using any so the driver
+    // compiles them side by side, the status is checked (waiting if needed) on first use
     Shader(const std::string& vertexPath, const std::string& fragmentPath);
+    // the build finished, using it now won't wait (always true without the extension, asking would wait)
+    bool isReady() const;
+    // submits a new program from the given sources, the current one is used until pollRebuild switches
+    void rebuild(const std::string& vertexCode, const std::string& fragmentCode);
+    // GL thread, switches to the rebuilt program once the driver is done with it, never waits
+    RebuildStatus pollRebuild();
+    // reads the files again, rebuilds and waits for it, true when it switched
+    bool reload();
+    // no GL calls, safe on any thread
+    bool readSources(std::string& vertexCode, std::string& fragmentCode) const;
+    const std::string& getVertexPath() const;
+    const std::string& getFragmentPath() const;
     // use/activate the shader
     void use();
-    // utility uniform functions
+    // utility uniform functions, after use() (the pending build has to be finished for the lookup)
     void setBool(const char* name, bool value) const;
     void setInt(const char* name, int value) const;
     void setFloat(const char* name, float value) const;
     void setVecf(const char* name, uint32_t count, const GLfloat* value) const;
     void setVeci(const char* name, uint32_t count, const GLint* value) const;
     void setMat4(const char* name, int count, const GLfloat* value) const;
+    // pre-resolved versions, get the handles while setting things up (not while another thread sets uniforms)
+    UniformHandle getUniform(const char* name);
+    void setBool(UniformHandle uniform, bool value) const;
+    void setInt(UniformHandle uniform, int value) const;
+    void setFloat(UniformHandle uniform, float value) const;
+    void setVecf(UniformHandle uniform, uint32_t count, const GLfloat* value) const;
+    void setVeci(UniformHandle uniform, uint32_t count, const GLint* value) const;
+    void setMat4(UniformHandle uniform, int count, const GLfloat* value) const;
+    // from the table built at link time, no driver call, -1 when it isn't an active uniform, only valid once the
+    // pending build finished (use() or getUniform() did that), before it every name would look inactive
+    int getUniformLocation(const char* name) const;
     void deleteShader() const;
     ~Shader();
+private:
+    void finishPendingBuild();
+    RebuildStatus completeRebuild(bool wait);
+    void buildUniformTable();
+    void addUniform(const std::string& name, int location);
+    int getLocation(UniformHandle uniform) const;
+
+    std::string vertexPath;
+    std::string fragmentPath;
+    Build build = {};
+    bool isBuildPending = false;
+    Build rebuildBuild = {};
+    bool isRebuildPending = false;
+    std::unordered_map<uint64_t, int> uniformLocations; // hash of the name, location
+    std::vector<std::string> handleNames; // what each handle was resolved from
+    std::vector<int> handleLocations; // handle index, location in the current program
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static const uint32_t magic = 0x42485347; //"GSHB"
+static const uint32_t version = 1;
+
+struct BinaryHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key; //the file name says it too, this catches renamed or half written files
+	uint32_t binaryFormat;
+	uint32_t length;
+};
+
+struct ShaderCacheData
+{
+	std::string directory;
+	uint64_t driverHash = 0;
+	int supported = -1; //not checked yet
+	ShaderCache::Stats stats = {};
+};
+
+static ShaderCacheData scData;
+
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size) //FNV-1a
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint64_t hashString(uint64_t hash, const char* text)
+{
+	hash = hashBytes(hash, text, text != nullptr ? strlen(text) : 0);
+	return hashBytes(hash, "", 1); //"ab" + "c" and "a" + "bc" hash differently
+}
+
+static std::string pathFor(uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	return scData.directory + "/" + name;
+}
+
+void ShaderCache::setDirectory(const std::string& directory)
+{
+	scData.directory = directory;
+}
+
+bool ShaderCache::isSupported()
+{
+	if (scData.supported < 0)
+	{
+		GLint formatCount = 0;
+		if (GLAD_GL_ARB_get_program_binary)
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+		scData.supported = formatCount > 0 ? 1 : 0; //some drivers have the entry points but no format
+
+		//binaries only load on the driver that made them
+		scData.driverHash = 14695981039346656037ull;
+		scData.driverHash = hashString(scData.driverHash, (const char*)glGetString(GL_VENDOR));
+		scData.driverHash = hashString(scData.driverHash, (const char*)glGetString(GL_RENDERER));
+		scData.driverHash = hashString(scData.driverHash, (const char*)glGetString(GL_VERSION));
+
+		if (scData.directory.empty())
+		{
+			std::string projectPath = std::filesystem::current_path().string();
+			std::replace(projectPath.begin(), projectPath.end(), '\\', '/');
+			scData.directory = projectPath + "/ShaderCache";
+		}
+	}
+	return scData.supported == 1;
+}
+
+uint64_t ShaderCache::getKey(const std::string& vertexCode, const std::string& fragmentCode)
+{
+	isSupported(); //hashes the driver strings
+	uint64_t key = scData.driverHash;
+	key = hashString(key, vertexCode.c_str());
+	key = hashString(key, fragmentCode.c_str());
+	return key;
+}
+
+GLuint ShaderCache::load(uint64_t key)
+{
+	if (!isSupported())
+		return 0;
+
+	std::string path = pathFor(key);
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		scData.stats.missCount++;
+		return 0;
+	}
+
+	BinaryHeader header = {};
+	std::vector<char> binary;
+	file.read((char*)&header, sizeof(header));
+	if (file && header.magic == magic && header.version == version && header.key == key && header.length > 0)
+	{
+		binary.resize(header.length);
+		file.read(binary.data(), header.length);
+	}
+	bool isValid = file && !binary.empty();
+	file.close();
+
+	GLuint program = 0;
+	if (isValid)
+	{
+		program = glCreateProgram();
+		glProgramBinary(program, (GLenum)header.binaryFormat, binary.data(), (GLsizei)binary.size());
+
+		int success;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			glDeleteProgram(program);
+			program = 0;
+		}
+	}
+
+	if (program == 0) //corrupt, or the driver changed in a way its strings don't show, build it from source again
+	{
+		std::cout << "ERROR::SHADER_CACHE::BINARY_REJECTED " << path << std::endl;
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		scData.stats.rejectedCount++;
+		scData.stats.missCount++;
+		return 0;
+	}
+
+	scData.stats.hitCount++;
+	return program;
+}
+
+void ShaderCache::prepare(GLuint program)
+{
+	if (isSupported())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ShaderCache::store(uint64_t key, GLuint program)
+{
+	if (!isSupported())
+		return;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(scData.directory, error);
+
+	//written under a temporary name and renamed, a crash never leaves a half written binary behind
+	std::string path = pathFor(key);
+	std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "ERROR::SHADER_CACHE::WRITE_FAILED " << temporaryPath << std::endl;
+			return;
+		}
+
+		BinaryHeader header = { magic, version, key, (uint32_t)binaryFormat, (uint32_t)length };
+		file.write((const char*)&header, sizeof(header));
+		file.write(binary.data(), length);
+		if (!file)
+		{
+			std::cout << "ERROR::SHADER_CACHE::WRITE_FAILED " << temporaryPath << std::endl;
+			return;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error)
+	{
+		std::cout << "ERROR::SHADER_CACHE::WRITE_FAILED " << path << std::endl;
+		std::filesystem::remove(temporaryPath, error);
+		return;
+	}
+
+	scData.stats.storedCount++;
+}
+
+const ShaderCache::Stats& ShaderCache::getStats()
+{
+	return scData.stats;
+}
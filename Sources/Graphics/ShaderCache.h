@@ -0,0 +1,34 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+#include <string>
+
+//keeps linked programs on disk (glGetProgramBinary) so later launches skip compiling and linking, a program is keyed
+//by the hash of its sources and of the driver (vendor, renderer and version strings), so an edit or a driver update
+//just misses, and a binary the driver rejects anyway is deleted and the program built from source again
+class ShaderCache
+{
+public:
+	static void setDirectory(const std::string& directory); //"ShaderCache" under the working directory by default
+	static bool isSupported(); //GL thread, the driver can hand out program binaries
+
+	//GL thread
+	static uint64_t getKey(const std::string& vertexCode, const std::string& fragmentCode);
+	static GLuint load(uint64_t key); //a linked program or 0
+	static void prepare(GLuint program); //before linking, so the driver keeps the binary around
+	static void store(uint64_t key, GLuint program); //after a successful link
+
+	//stats
+	struct Stats
+	{
+		unsigned int hitCount;
+		unsigned int missCount;
+		unsigned int rejectedCount; //binaries the driver didn't take
+		unsigned int storedCount;
+	};
+
+	static const Stats& getStats();
+};
+
+#endif
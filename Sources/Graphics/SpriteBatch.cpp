@@ -1,16 +1,28 @@
 #include "SpriteBatch.h"
+#include "TextureStreamer.h"
+#include "GLState.h"
 #include <array>
 #include <glad/glad.h>
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 using namespace std;
 
 static const size_t maxQuadCount = 1000;
 static const size_t maxVerticesCount = maxQuadCount * 4;
-static const size_t maxIndexCount = maxQuadCount * 6;
+static const size_t maxIndexCount = maxVerticesCount * 3; //enough for any convex polygon (n vertices => 3 * (n - 2) indices)
 static const size_t maxTextureCount = 16; //this should be queried from GPU, since each gpu differ in the amount of textures it can store
 
+struct SpriteKey //sort key of a sprite (quad or outline polygon) recorded in the quad buffer
+{
+    float depth;
+    unsigned int firstVertex; //sprites are appended to the quad buffer, so this is the submission order too
+    unsigned int vertexCount;
+};
+
 struct RendererData
 {
     GLuint quadVA = 0; //vertex array
@@ -24,12 +36,26 @@ struct RendererData
 
     Vertex* quadBuffer = nullptr; //this a pointer to the buffer holding the quads
     Vertex* quadBufferPtr = nullptr; //this is a pointer to where we are in the buffer (reset every frame)
+    Vertex* sortedBuffer = nullptr; //sprites reordered for submission: opaque front-to-back, then transparent back-to-front
+
+    std::vector<SpriteKey> opaqueSprites; //fully opaque sprites (opaque texture and color alpha of 1)
+    std::vector<SpriteKey> transparentSprites; //everything else, needs blending
+    GLuint opaqueIndexCount = 0; //indices of the opaque pass, the transparent pass starts right after them
 
-    unsigned int* indices = nullptr;
+    unsigned int* indices = nullptr; //rebuilt every batch, sprites are triangle fans of different sizes
 
-    std::map<Texture*, Texture*> textureSlots;
+    std::map<std::pair<Texture*, GLuint>, unsigned int> textureSlots; //texture and sampler object => slot, the same image sampled two ways takes two slots
     unsigned int textureSlotIndex = 1; //next free space to insert a new texture
 
+    std::vector<SamplerDesc> samplers; //stack of sampler overrides, empty uses each texture's own sampler
+    SpriteBatch::BlendMode blendMode = SpriteBatch::Alpha;
+
+    std::vector<glm::vec4> clipRects; //stack of min x, min y, max x, max y, the top is the intersection of all of them
+    std::vector<Vertex> clipScratch; //clipPolygon swaps between these two, they keep their capacity across sprites
+    std::vector<Vertex> clipOutput;
+
+    RenderTarget* renderTarget = nullptr; //bound during flush(), nullptr keeps the current framebuffer
+
     SpriteBatch::Stats renderStats; //this is just some stats
 };
 
@@ -46,14 +72,17 @@ void SpriteBatch::init()
 
     //allocate memory
     rData.quadBuffer = new Vertex[maxVerticesCount];
+    rData.sortedBuffer = new Vertex[maxVerticesCount];
+    rData.opaqueSprites.reserve(maxQuadCount);
+    rData.transparentSprites.reserve(maxQuadCount);
 
     //vertex array
     glGenVertexArrays(1, &rData.quadVA);
-    glBindVertexArray(rData.quadVA);
+    GLState::bindVertexArray(rData.quadVA);
 
     //vertex buffer
     glGenBuffers(1, &rData.quadVB);
-    glBindBuffer(GL_ARRAY_BUFFER, rData.quadVB);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, rData.quadVB);
     glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * maxVerticesCount, nullptr, GL_DYNAMIC_DRAW); //reserving data only without initializing them
 
     //pos
@@ -72,111 +101,437 @@ void SpriteBatch::init()
     glEnableVertexAttribArray(3);
     glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, texID));
 
+    //shape type
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, shapeType));
+
+    //shape params
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, shapeParams));
+
     //index buffer
     rData.indices = new unsigned int[maxIndexCount];
-    int offset = 0;
-    for (size_t i = 0; i < maxIndexCount; i += 6)
-    {
-        rData.indices[i] = offset;
-        rData.indices[i + 1] = offset + 1;
-        rData.indices[i + 2] = offset + 2;
-        rData.indices[i + 3] = offset + 2;
-        rData.indices[i + 4] = offset + 3;
-        rData.indices[i + 5] = offset + 0;
-
-        offset += 4;
-    }
 
     glGenBuffers(1, &rData.quadIB);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rData.quadIB);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, maxIndexCount * sizeof(unsigned int), rData.indices, GL_STATIC_DRAW); //note: indices buffer is static, data itself doesn't change
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, rData.quadIB);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, maxIndexCount * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW); //filled in end(), after sorting
 
     rData.whiteTexture = new Texture();
 
-    rData.textureSlots[rData.whiteTexture] = rData.whiteTexture; //assign white texture as the first texture in texture slots
+    rData.textureSlots[{ rData.whiteTexture, rData.whiteTexture->getSampler() }] = rData.whiteTextureSlot; //assign white texture as the first texture in texture slots
     //for (unsigned int i = 1; i < maxTextureCount; i++) //initialize all places with 0 as default texture (white texture)
     //    rData.textureSlots[i] = *rData.whiteTexture;
 }
 
 void SpriteBatch::shutDown()
 {
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
     glDeleteVertexArrays(1, &rData.quadVA);
     glDeleteBuffers(1, &rData.quadVB);
     glDeleteBuffers(1, &rData.quadIB);
+    GLState::onVertexArrayDeleted(rData.quadVA);
+    GLState::onBufferDeleted(rData.quadVB);
+    GLState::onBufferDeleted(rData.quadIB);
     rData.whiteTexture->deleteTexture();
 
     delete rData.whiteTexture;
     delete[] rData.quadBuffer;
+    delete[] rData.sortedBuffer;
     delete[] rData.indices;
 }
 
 void SpriteBatch::begin()
 {
     rData.quadBufferPtr = rData.quadBuffer; //reset pointer to begining if quad buffer
+    rData.opaqueSprites.clear();
+    rData.transparentSprites.clear();
 }
 
 void SpriteBatch::end() //here, we submit data for rendering to GPU
 {
-    GLsizeiptr size = (uint8_t*)rData.quadBufferPtr - (uint8_t*)rData.quadBuffer; //size of the actual data used from the quad buffer
-    glBindBuffer(GL_ARRAY_BUFFER, rData.quadVB);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, size, rData.quadBuffer);
+    //opaque sprites go front-to-back so early-z rejects the hidden fragments, ties keep submission order (depth func is LEQUAL, last one wins)
+    std::sort(rData.opaqueSprites.begin(), rData.opaqueSprites.end(), [](const SpriteKey& a, const SpriteKey& b)
+        { return a.depth > b.depth || (a.depth == b.depth && a.firstVertex < b.firstVertex); });
+    //transparent sprites go back-to-front (painter's order) so blending is correct
+    std::sort(rData.transparentSprites.begin(), rData.transparentSprites.end(), [](const SpriteKey& a, const SpriteKey& b)
+        { return a.depth < b.depth || (a.depth == b.depth && a.firstVertex < b.firstVertex); });
+
+    Vertex* target = rData.sortedBuffer;
+    unsigned int* index = rData.indices;
+    auto emitSprite = [&](const SpriteKey& key)
+    {
+        unsigned int base = (unsigned int)(target - rData.sortedBuffer);
+        memcpy(target, rData.quadBuffer + key.firstVertex, sizeof(Vertex) * key.vertexCount);
+        target += key.vertexCount;
+
+        for (unsigned int i = 1; i + 1 < key.vertexCount; i++) //triangle fan, sprites are always convex
+        {
+            *index++ = base;
+            *index++ = base + i;
+            *index++ = base + i + 1;
+        }
+    };
+
+    for (const SpriteKey& key : rData.opaqueSprites)
+        emitSprite(key);
+    rData.opaqueIndexCount = (GLuint)(index - rData.indices);
+    for (const SpriteKey& key : rData.transparentSprites)
+        emitSprite(key);
+
+    GLsizeiptr size = (uint8_t*)target - (uint8_t*)rData.sortedBuffer; //size of the actual data used from the quad buffer
+    GLState::bindBuffer(GL_ARRAY_BUFFER, rData.quadVB);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, rData.sortedBuffer);
+
+    GLState::bindVertexArray(rData.quadVA); //the element buffer binding is part of the vertex array state
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, rData.quadIB);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, (uint8_t*)index - (uint8_t*)rData.indices, rData.indices);
 }
 
 void SpriteBatch::flush() //actual rendering of quads
 {
-    int iterator = 0;
+    //the target only applies to this flush, whatever was bound before (the backbuffer, a graph pass) is restored after it
+    GLint previousFramebuffer = 0;
+    GLint previousViewport[4] = {};
+    if (rData.renderTarget != nullptr)
+    {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, previousViewport);
+        rData.renderTarget->bind();
+    }
+
     for (auto const& x : rData.textureSlots)
     {
-        x.second->bindTexture();
-        bindTextureGivenIndex(x.second->getTexID());
+        GLState::bindTexture(x.second, x.first.first->getGLTexture()); //only switches units for slots that changed since the last flush
+        GLState::bindSampler(x.second, x.first.second); //overrides the texture's own parameters
     }
 
-    glBindVertexArray(rData.quadVA);
-    glDrawElements(GL_TRIANGLES, rData.indexCount, GL_UNSIGNED_INT, 0);
-    rData.renderStats.drawCount++; //gpu draw calls
+    GLState::bindVertexArray(rData.quadVA);
+    GLState::setDepthFunc(GL_LEQUAL); //quads on the same layer share the same depth
+
+    //opaque pass: depth writes on, no blending
+    if (rData.opaqueIndexCount > 0)
+    {
+        GLState::setBlend(false);
+        GLState::setDepthMask(true);
+        glDrawElements(GL_TRIANGLES, rData.opaqueIndexCount, GL_UNSIGNED_INT, 0);
+        rData.renderStats.drawCount++; //gpu draw calls
+    }
+
+    //transparent pass: tested against the opaque depth but doesn't write it
+    if (rData.indexCount > rData.opaqueIndexCount)
+    {
+        GLState::setBlend(true);
+        GLState::setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA); //premultiplied alpha
+        GLState::setDepthMask(false);
+        glDrawElements(GL_TRIANGLES, rData.indexCount - rData.opaqueIndexCount, GL_UNSIGNED_INT, (const void*)(rData.opaqueIndexCount * sizeof(unsigned int)));
+        GLState::setDepthMask(true);
+        rData.renderStats.drawCount++; //gpu draw calls
+    }
+
+    //samplers override the parameters of whatever gets bound to the unit next, other code expects the texture's own
+    for (auto const& x : rData.textureSlots)
+        GLState::bindSampler(x.second, 0);
+
+    if (rData.renderTarget != nullptr)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+        glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    }
 
     //reset
     rData.indexCount = 0;
+    rData.opaqueIndexCount = 0;
+    rData.textureSlots.clear();
+    rData.textureSlots[{ rData.whiteTexture, rData.whiteTexture->getSampler() }] = rData.whiteTextureSlot;
     rData.textureSlotIndex = 1;
 }
 
-void SpriteBatch::drawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+void SpriteBatch::setRenderTarget(RenderTarget* target)
+{
+    rData.renderTarget = target;
+}
+
+RenderTarget* SpriteBatch::getRenderTarget()
+{
+    return rData.renderTarget;
+}
+
+static Vertex lerpVertex(const Vertex& a, const Vertex& b, float t) //only position and texCoord vary inside a sprite
+{
+    Vertex v = a;
+    v.position = a.position + (b.position - a.position) * t;
+    v.texCoord = a.texCoord + (b.texCoord - a.texCoord) * t;
+    return v;
+}
+
+//clips the convex polygon in place (sutherland-hodgman against each side of the rect), it can grow by up to 4 vertices
+static unsigned int clipPolygon(Vertex* vertices, unsigned int count, const glm::vec4& rect, std::vector<Vertex>& scratch, std::vector<Vertex>& output)
+{
+    glm::vec2 minPos(vertices[0].position), maxPos(vertices[0].position);
+    for (unsigned int i = 1; i < count; i++)
+    {
+        minPos = glm::min(minPos, glm::vec2(vertices[i].position));
+        maxPos = glm::max(maxPos, glm::vec2(vertices[i].position));
+    }
+    if (minPos.x >= rect.x && minPos.y >= rect.y && maxPos.x <= rect.z && maxPos.y <= rect.w) //fully inside
+        return count;
+    if (maxPos.x <= rect.x || maxPos.y <= rect.y || minPos.x >= rect.z || minPos.y >= rect.w) //fully outside
+        return 0;
+
+    scratch.assign(vertices, vertices + count);
+    for (int side = 0; side < 4; side++)
+    {
+        int axis = side & 1; //x, y, x, y
+        float bound = rect[side];
+        float sign = side < 2 ? 1.0f : -1.0f; //min sides keep the greater values, max sides the smaller ones
+
+        output.clear();
+        for (size_t i = 0; i < scratch.size(); i++)
+        {
+            const Vertex& a = scratch[i];
+            const Vertex& b = scratch[(i + 1) % scratch.size()];
+            float da = (a.position[axis] - bound) * sign; //>= 0 is inside
+            float db = (b.position[axis] - bound) * sign;
+
+            if (da >= 0.0f)
+                output.push_back(a);
+            if ((da >= 0.0f) != (db >= 0.0f))
+                output.push_back(lerpVertex(a, b, da / (da - db)));
+        }
+
+        scratch.swap(output);
+        if (scratch.size() < 3)
+            return 0;
+    }
+
+    std::copy(scratch.begin(), scratch.end(), vertices);
+    return (unsigned int)scratch.size();
+}
+
+void SpriteBatch::pushClipRect(const glm::vec2& position, const glm::vec2& size)
+{
+    glm::vec4 rect(position, position + size);
+    if (!rData.clipRects.empty()) //nested, only what's visible in the parent too
+    {
+        const glm::vec4& parent = rData.clipRects.back();
+        rect = glm::vec4(glm::max(glm::vec2(rect), glm::vec2(parent)), glm::min(glm::vec2(rect.z, rect.w), glm::vec2(parent.z, parent.w)));
+    }
+
+    rData.clipRects.push_back(rect);
+}
+
+void SpriteBatch::popClipRect()
+{
+    if (!rData.clipRects.empty())
+        rData.clipRects.pop_back();
+}
+
+void SpriteBatch::pushSampler(const SamplerDesc& sampler)
+{
+    rData.samplers.push_back(sampler);
+}
+
+void SpriteBatch::popSampler()
+{
+    if (!rData.samplers.empty())
+        rData.samplers.pop_back();
+}
+
+void SpriteBatch::setBlendMode(BlendMode mode)
 {
-    if (rData.indexCount >= maxIndexCount) //reached maximum nuber of quads rendered in a single draw call
+    rData.blendMode = mode;
+}
+
+void SpriteBatch::reserve(unsigned int vertexCount, unsigned int spriteCount)
+{
+    if (!rData.clipRects.empty()) //clipping adds up to 4 vertices per sprite
+        vertexCount += spriteCount * 4;
+
+    if (rData.quadBufferPtr + vertexCount > rData.quadBuffer + maxVerticesCount) //reached maximum nuber of quads rendered in a single draw call
     {
         end();
         flush();
         begin();
     }
-
-    rData.quadBufferPtr = createQuad(rData.quadBufferPtr, position.x, position.y, (float)rData.whiteTexture->getTexID(), color, size);
-    rData.indexCount += 6; //a quad
-    rData.renderStats.quadCount++;
 }
 
-void SpriteBatch::drawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, Texture* tex)
+float SpriteBatch::prepareTexture(Texture* tex, unsigned int vertexCount, unsigned int spriteCount)
 {
-    if (rData.indexCount >= maxIndexCount || (rData.textureSlotIndex >= maxTextureCount && !rData.textureSlots.count(tex))) //reached maximum nuber of quads rendered in a single draw call
+    GLuint sampler = rData.samplers.empty() ? tex->getSampler() : SamplerCache::get(rData.samplers.back());
+    std::pair<Texture*, GLuint> key(tex, sampler);
+
+    if (rData.textureSlotIndex >= maxTextureCount && !rData.textureSlots.count(key)) //no free texture slot
     {
         end();
         flush();
         begin();
     }
+    reserve(vertexCount, spriteCount);
+
+    auto it = rData.textureSlots.find(key);
+    if (it != rData.textureSlots.end()) //texture exists
+        return (float)it->second;
+
+    float texIndex = (float)rData.textureSlotIndex;
+    rData.textureSlots[key] = rData.textureSlotIndex;
+    rData.textureSlotIndex++;
+    return texIndex;
+}
+
+void SpriteBatch::submitSprite(unsigned int vertexCount, float depth, bool isOpaque)
+{
+    if (!rData.clipRects.empty())
+    {
+        Vertex* first = rData.quadBufferPtr - vertexCount;
+        vertexCount = clipPolygon(first, vertexCount, rData.clipRects.back(), rData.clipScratch, rData.clipOutput);
+        rData.quadBufferPtr = first + vertexCount;
+        if (vertexCount == 0)
+        {
+            rData.renderStats.clippedQuadCount++;
+            return;
+        }
+    }
+
+    //textures are premultiplied at load, so the tint is too, an alpha of 0 adds the color instead of covering
+    //what's behind (GL_ONE, GL_ONE_MINUS_SRC_ALPHA does both), so additive sprites don't need a blend state of their own
+    for (Vertex* vertex = rData.quadBufferPtr - vertexCount; vertex != rData.quadBufferPtr; vertex++)
+        vertex->color = glm::vec4(glm::vec3(vertex->color) * vertex->color.a, rData.blendMode == Additive ? 0.0f : vertex->color.a);
+    isOpaque = isOpaque && rData.blendMode == Alpha;
 
-    float texIndex = 0.0f;
-    if (rData.textureSlots.count(tex)) //texture exists
-        texIndex = (float)tex->getTexID();
+    unsigned int firstVertex = (unsigned int)(rData.quadBufferPtr - rData.quadBuffer) - vertexCount; //the sprite was just written to the buffer
+    if (isOpaque)
+    {
+        rData.opaqueSprites.push_back({ depth, firstVertex, vertexCount });
+        rData.renderStats.opaqueQuadCount++;
+    }
     else
     {
-        texIndex = (float)rData.textureSlotIndex;
-        rData.textureSlots[tex] = tex;
-        rData.textureSlotIndex++;
+        rData.transparentSprites.push_back({ depth, firstVertex, vertexCount });
+        rData.renderStats.transparentQuadCount++;
     }
 
-    rData.quadBufferPtr = createQuad(rData.quadBufferPtr, position.x, position.y, texIndex, color, size);
-    rData.indexCount += 6; //a quad
+    rData.indexCount += (vertexCount - 2) * 3; //a triangle fan
     rData.renderStats.quadCount++;
+    rData.renderStats.vertexCount += vertexCount;
+}
+
+void SpriteBatch::drawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, float depth)
+{
+    reserve(4);
+
+    rData.quadBufferPtr = createQuad(rData.quadBufferPtr, position.x, position.y, depth, (float)rData.whiteTextureSlot, color, size);
+    submitSprite(4, depth, color.a >= 1.0f);
+}
+
+void SpriteBatch::drawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, Texture* tex, float depth)
+{
+    TextureStreamer::noteUse(tex, size); //before the placeholder swap, an evicted texture reloads once it's drawn
+    if (!tex->isReady()) //still loading, draw the placeholder
+        tex = rData.whiteTexture;
+
+    unsigned int vertexCount = tex->outline.empty() ? 4 : (unsigned int)tex->outline.size(); //trimmed outline if the texture has one
+    float texIndex = prepareTexture(tex, vertexCount);
+
+    if (tex->outline.empty())
+        rData.quadBufferPtr = createQuad(rData.quadBufferPtr, position.x, position.y, depth, texIndex, color, size);
+    else
+        rData.quadBufferPtr = createPolygon(rData.quadBufferPtr, position, size, depth, texIndex, color, tex->outline);
+    submitSprite(vertexCount, depth, color.a >= 1.0f && tex->isOpaque);
+}
+
+void SpriteBatch::drawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, const TextureAtlas::Region& region, float depth)
+{
+    float texIndex = prepareTexture(region.texture, 4);
+
+    rData.quadBufferPtr = createQuad(rData.quadBufferPtr, position.x, position.y, depth, texIndex, color, size, region.uvRect);
+    submitSprite(4, depth, color.a >= 1.0f && region.isOpaque);
+}
+
+void SpriteBatch::drawNineSlice(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, Texture* tex, const glm::vec4& border, float texelSize, float depth)
+{
+    TextureStreamer::noteUse(tex, glm::vec2((float)tex->width, (float)tex->height) * texelSize); //the borders are drawn at texelSize per texel
+    if (!tex->isReady()) //still loading, draw the placeholder
+        tex = rData.whiteTexture;
+
+    float texIndex = prepareTexture(tex, 9 * 4, 9); //all 9 quads go in at once
+
+    //corners shrink evenly if the panel is smaller than its borders
+    glm::vec4 worldBorder = border * texelSize;
+    float scaleX = worldBorder.x + worldBorder.y > size.x ? size.x / (worldBorder.x + worldBorder.y) : 1.0f;
+    float scaleY = worldBorder.z + worldBorder.w > size.y ? size.y / (worldBorder.z + worldBorder.w) : 1.0f;
+
+    const float xs[4] = { position.x, position.x + worldBorder.x * scaleX, position.x + size.x - worldBorder.y * scaleX, position.x + size.x };
+    const float ys[4] = { position.y, position.y + worldBorder.z * scaleY, position.y + size.y - worldBorder.w * scaleY, position.y + size.y };
+    const float us[4] = { 0.0f, border.x / tex->width, 1.0f - border.y / tex->width, 1.0f };
+    const float vs[4] = { 0.0f, border.z / tex->height, 1.0f - border.w / tex->height, 1.0f };
+
+    bool isOpaque = color.a >= 1.0f && tex->isOpaque;
+    for (int row = 0; row < 3; row++)
+        for (int column = 0; column < 3; column++)
+        {
+            glm::vec2 cellSize(xs[column + 1] - xs[column], ys[row + 1] - ys[row]);
+            if (cellSize.x <= 0.0f || cellSize.y <= 0.0f) //no border on that side
+                continue;
+
+            glm::vec4 uvRect(us[column], vs[row], us[column + 1], vs[row + 1]);
+            rData.quadBufferPtr = createQuad(rData.quadBufferPtr, xs[column], ys[row], depth, texIndex, color, cellSize, uvRect);
+            submitSprite(4, depth, isOpaque);
+        }
+}
+
+void SpriteBatch::drawLine(const glm::vec2& from, const glm::vec2& to, float thickness, const glm::vec4& color, float depth)
+{
+    glm::vec2 direction = to - from;
+    float length = glm::length(direction);
+    glm::vec2 axis = length > 0.0f ? direction / length : glm::vec2(1.0f, 0.0f);
+
+    //a capsule: the quad covers the round caps too
+    glm::vec2 halfSize(length * 0.5f + thickness * 0.5f, thickness * 0.5f);
+    drawShape((from + to) * 0.5f, axis, halfSize, depth, color, (float)RoundedRect, glm::vec4(halfSize, thickness * 0.5f, 0.0f));
+}
+
+void SpriteBatch::drawCircle(const glm::vec2& center, float radius, const glm::vec4& color, float thickness, float depth)
+{
+    glm::vec2 halfSize(radius);
+    drawShape(center, glm::vec2(1.0f, 0.0f), halfSize, depth, color, (float)Circle, glm::vec4(halfSize, 0.0f, thickness));
+}
+
+void SpriteBatch::drawRect(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, float thickness, float cornerRadius, float depth)
+{
+    glm::vec2 halfSize = size * 0.5f;
+    if (thickness <= 0.0f && cornerRadius <= 0.0f) //plain filled rect, no need for the distance field
+    {
+        drawQuad(position, size, color, depth);
+        return;
+    }
+
+    drawShape(position + halfSize, glm::vec2(1.0f, 0.0f), halfSize, depth, color, (float)RoundedRect, glm::vec4(halfSize, cornerRadius, thickness));
+}
+
+void SpriteBatch::drawShape(const glm::vec2& center, const glm::vec2& axis, const glm::vec2& halfSize, float depth, const glm::vec4& color, float shapeType, const glm::vec4& shapeParams)
+{
+    reserve(4);
+
+    //corners of the (possibly rotated) quad, texCoord gives the fragment shader its position inside the shape
+    glm::vec2 x = axis * halfSize.x;
+    glm::vec2 y = glm::vec2(-axis.y, axis.x) * halfSize.y;
+    const glm::vec2 corners[4] = { center - x - y, center + x - y, center + x + y, center - x + y };
+    const glm::vec2 texCoords[4] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+    Vertex* target = rData.quadBufferPtr;
+    for (int i = 0; i < 4; i++)
+    {
+        target->position = { corners[i].x, corners[i].y, depth };
+        target->texCoord = texCoords[i];
+        target->color = color;
+        target->texID = (float)rData.whiteTextureSlot;
+        target->shapeType = shapeType;
+        target->shapeParams = shapeParams;
+        target++;
+    }
+    rData.quadBufferPtr = target;
+
+    submitSprite(4, depth, false); //anti-aliased edges need blending
 }
 
 const SpriteBatch::Stats& SpriteBatch::getStats()
@@ -191,136 +546,56 @@ void SpriteBatch::resetStats()
 }
 
 /////////////////////////////////
-Vertex* SpriteBatch::createQuad(Vertex* target, float x, float y, float texID, const glm::vec4& color, const glm::vec2& size)
+Vertex* SpriteBatch::createQuad(Vertex* target, float x, float y, float depth, float texID, const glm::vec4& color, const glm::vec2& size, const glm::vec4& uvRect)
 {
-    target->position = { x, y, 0.0f };
-    target->texCoord = { 0.0f, 0.0f };
+    target->position = { x, y, depth };
+    target->texCoord = { uvRect.x, uvRect.y };
     target->color = color;
     target->texID = texID;
+    target->shapeType = 0.0f;
+    target->shapeParams = glm::vec4(0.0f);
     target++;
 
-    target->position = { x + size.x,  y, 0.0f };
-    target->texCoord = { 1.0f, 0.0f };
+    target->position = { x + size.x,  y, depth };
+    target->texCoord = { uvRect.z, uvRect.y };
     target->color = color;
     target->texID = texID;
+    target->shapeType = 0.0f;
+    target->shapeParams = glm::vec4(0.0f);
     target++;
 
-    target->position = { x + size.x,  y + size.y, 0.0f };
-    target->texCoord = { 1.0f, 1.0f };
+    target->position = { x + size.x,  y + size.y, depth };
+    target->texCoord = { uvRect.z, uvRect.w };
     target->color = color;
     target->texID = texID;
+    target->shapeType = 0.0f;
+    target->shapeParams = glm::vec4(0.0f);
     target++;
 
-    target->position = { x,  y + size.y, 0.0f };
-    target->texCoord = { 0.0f, 1.0f };
+    target->position = { x,  y + size.y, depth };
+    target->texCoord = { uvRect.x, uvRect.w };
     target->color = color;
     target->texID = texID;
+    target->shapeType = 0.0f;
+    target->shapeParams = glm::vec4(0.0f);
     target++;
 
     return target;
 }
 
-void SpriteBatch::bindTextureGivenIndex(int index)
+Vertex* SpriteBatch::createPolygon(Vertex* target, const glm::vec2& position, const glm::vec2& size, float depth, float texID, const glm::vec4& color, const std::vector<glm::vec2>& outline)
 {
-    switch (index)
+    for (const glm::vec2& uv : outline) //outline is in uv space, so it maps to the quad the same way the texture does
     {
-    case 0:
-        glActiveTexture(GL_TEXTURE0);
-        break;
-    case 1:
-        glActiveTexture(GL_TEXTURE1);
-        break;
-    case 2:
-        glActiveTexture(GL_TEXTURE2);
-        break;
-    case 3:
-        glActiveTexture(GL_TEXTURE3);
-        break;
-    case 4:
-        glActiveTexture(GL_TEXTURE4);
-        break;
-    case 5:
-        glActiveTexture(GL_TEXTURE5);
-        break;
-    case 6:
-        glActiveTexture(GL_TEXTURE6);
-        break;
-    case 7:
-        glActiveTexture(GL_TEXTURE7);
-        break;
-    case 8:
-        glActiveTexture(GL_TEXTURE8);
-        break;
-    case 9:
-        glActiveTexture(GL_TEXTURE9);
-        break;
-    case 10:
-        glActiveTexture(GL_TEXTURE10);
-        break;
-    case 11:
-        glActiveTexture(GL_TEXTURE11);
-        break;
-    case 12:
-        glActiveTexture(GL_TEXTURE12);
-        break;
-    case 13:
-        glActiveTexture(GL_TEXTURE13);
-        break;
-    case 14:
-        glActiveTexture(GL_TEXTURE14);
-        break;
-    case 15:
-        glActiveTexture(GL_TEXTURE15);
-        break;
-    case 16:
-        glActiveTexture(GL_TEXTURE16);
-        break;
-    case 17:
-        glActiveTexture(GL_TEXTURE17);
-        break;
-    case 18:
-        glActiveTexture(GL_TEXTURE18);
-        break;
-    case 19:
-        glActiveTexture(GL_TEXTURE19);
-        break;
-    case 20:
-        glActiveTexture(GL_TEXTURE20);
-        break;
-    case 21:
-        glActiveTexture(GL_TEXTURE21);
-        break;
-    case 22:
-        glActiveTexture(GL_TEXTURE22);
-        break;
-    case 23:
-        glActiveTexture(GL_TEXTURE23);
-        break;
-    case 24:
-        glActiveTexture(GL_TEXTURE24);
-        break;
-    case 25:
-        glActiveTexture(GL_TEXTURE25);
-        break;
-    case 26:
-        glActiveTexture(GL_TEXTURE26);
-        break;
-    case 27:
-        glActiveTexture(GL_TEXTURE27);
-        break;
-    case 28:
-        glActiveTexture(GL_TEXTURE28);
-        break;
-    case 29:
-        glActiveTexture(GL_TEXTURE29);
-        break;
-    case 30:
-        glActiveTexture(GL_TEXTURE30);
-        break;
-    case 31:
-        glActiveTexture(GL_TEXTURE31);
-        break;
-    default:
-        break;
+        target->position = { position.x + uv.x * size.x, position.y + uv.y * size.y, depth };
+        target->texCoord = uv;
+        target->color = color;
+        target->texID = texID;
+        target->shapeType = 0.0f;
+        target->shapeParams = glm::vec4(0.0f);
+        target++;
     }
+
+    return target;
 }
+
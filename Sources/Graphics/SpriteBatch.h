@@ -2,7 +2,10 @@
 #define SPRITE_BATCH
 
 #include <glm/glm.hpp>
+#include <vector>
 #include "Texture.h"
+#include "RenderTarget.h"
+#include "TextureAtlas.h"
 
 struct Vertex //keep this order!!
 {
@@ -10,6 +13,8 @@ struct Vertex //keep this order!!
 	glm::vec2 texCoord;
 	glm::vec4 color;
 	float texID;
+	float shapeType; //0: texture, otherwise a SpriteBatch::Shape evaluated as a signed distance field in the fragment shader
+	glm::vec4 shapeParams; //half width, half height, corner radius, outline thickness (0 fills the shape)
 };
 
 //this batch renderer is specific for 2d rendering only!, it's based on the Cherno implementation of a 2D batch renderer
@@ -20,9 +25,20 @@ private:
 	static bool initCalled;
 
 	//helper functions
-	static Vertex* createQuad(Vertex* target, float x, float y, float texID, const glm::vec4& color, const glm::vec2& size);
-	static void bindTextureGivenIndex(int index);
+	static Vertex* createQuad(Vertex* target, float x, float y, float depth, float texID, const glm::vec4& color, const glm::vec2& size, const glm::vec4& uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+	static Vertex* createPolygon(Vertex* target, const glm::vec2& position, const glm::vec2& size, float depth, float texID, const glm::vec4& color, const std::vector<glm::vec2>& outline);
+	static void reserve(unsigned int vertexCount, unsigned int spriteCount = 1);
+	static float prepareTexture(Texture* tex, unsigned int vertexCount, unsigned int spriteCount = 1);
+	static void submitSprite(unsigned int vertexCount, float depth, bool isOpaque);
+	static void drawShape(const glm::vec2& center, const glm::vec2& axis, const glm::vec2& halfSize, float depth, const glm::vec4& color, float shapeType, const glm::vec4& shapeParams);
 public:
+	enum Shape
+	{
+		Sprite = 0,
+		Circle = 1,
+		RoundedRect = 2 //lines are rounded rects with the corner radius set to half their thickness
+	};
+
 	static void init();
 	static void shutDown();
 
@@ -30,14 +46,53 @@ public:
 	static void end();
 	static void flush();
 
-	static void drawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color);
-	static void drawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, Texture* tex);
+	//target of the next flushes (the previous framebuffer and viewport are restored after each one), nullptr draws into
+	//whatever framebuffer is bound (the default one or a render graph pass)
+	//multisampled targets need a resolve() after the last flush before their texture is sampled
+	static void setRenderTarget(RenderTarget* target);
+	static RenderTarget* getRenderTarget();
+
+	//depth is the layer of the quad (written to position.z), higher depth is closer to the camera and drawn on top
+	static void drawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, float depth = 0.0f);
+	static void drawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, Texture* tex, float depth = 0.0f);
+	static void drawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, const TextureAtlas::Region& region, float depth = 0.0f); //batches with everything else on the same page
+
+	//vector shapes, they are quads like sprites so they batch with them (thickness 0 fills the shape, otherwise only the outline is drawn)
+	static void drawLine(const glm::vec2& from, const glm::vec2& to, float thickness, const glm::vec4& color, float depth = 0.0f);
+	static void drawCircle(const glm::vec2& center, float radius, const glm::vec4& color, float thickness = 0.0f, float depth = 0.0f);
+	static void drawRect(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, float thickness = 0.0f, float cornerRadius = 0.0f, float depth = 0.0f);
+
+	//9-slice: corners keep their size, edges stretch along one axis and the center along both
+	//border is left, right, bottom, top in texels, texelSize is the size of a texel in world units
+	static void drawNineSlice(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, Texture* tex, const glm::vec4& border, float texelSize = 1.0f, float depth = 0.0f);
+
+	//everything drawn until the matching pop is clipped to the rect (intersected with the enclosing clip rects)
+	//clipping is done on the cpu, so changing the clip rect doesn't break the batch
+	static void pushClipRect(const glm::vec2& position, const glm::vec2& size);
+	static void popClipRect();
+
+	//everything drawn until the matching pop is sampled with this instead of each texture's own sampler (nearest for pixel art, repeat for tiling...)
+	static void pushSampler(const SamplerDesc& sampler);
+	static void popSampler();
+
+	//how the draws after it combine with what's behind them, both kinds go in the same batch and draw call
+	enum BlendMode
+	{
+		Alpha, //covers by alpha
+		Additive, //adds the color scaled by alpha (glows, particles)
+	};
+
+	static void setBlendMode(BlendMode mode);
 
 	//stats
 	struct Stats
 	{
 		unsigned int drawCount;
-		unsigned int quadCount;
+		unsigned int quadCount; //sprites, drawn either as a quad or as the trimmed outline of their texture
+		unsigned int vertexCount;
+		unsigned int opaqueQuadCount; //quads drawn in the front-to-back pass (depth write, no blending)
+		unsigned int transparentQuadCount; //quads drawn in the back-to-front pass (blending, no depth write)
+		unsigned int clippedQuadCount; //quads fully outside the clip rect, not drawn at all
 	};
 
 	static const Stats& getStats();
@@ -0,0 +1,134 @@
+#include "SpriteOutline.h"
+#include <algorithm>
+
+static const float minSavedArea = 0.1f; //polygons that save less than this fraction of the quad aren't worth the extra vertices
+
+static float cross(const glm::vec2& o, const glm::vec2& a, const glm::vec2& b)
+{
+	return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+std::vector<glm::vec2> SpriteOutline::compute(const unsigned char* pixels, int width, int height, int numberOfChannels, int maxVertices, unsigned char alphaThreshold)
+{
+	if (pixels == nullptr || width <= 0 || height <= 0 || (numberOfChannels != 2 && numberOfChannels != 4) || maxVertices < 3)
+		return {};
+
+	//the hull of a row span only depends on its end points, so every visible row adds the 4 corners of its span
+	std::vector<glm::vec2> points;
+	points.reserve((size_t)height * 4);
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = pixels + (size_t)y * width * numberOfChannels + numberOfChannels - 1;
+		int minX = 0;
+		while (minX < width && row[minX * numberOfChannels] <= alphaThreshold)
+			minX++;
+		if (minX == width) //empty row
+			continue;
+
+		int maxX = width - 1;
+		while (row[maxX * numberOfChannels] <= alphaThreshold)
+			maxX--;
+
+		points.push_back({ (float)minX, (float)y });
+		points.push_back({ (float)maxX + 1.0f, (float)y });
+		points.push_back({ (float)minX, (float)y + 1.0f });
+		points.push_back({ (float)maxX + 1.0f, (float)y + 1.0f });
+	}
+
+	if (points.empty()) //fully transparent, keep the quad
+		return {};
+
+	std::vector<glm::vec2> hull = convexHull(points);
+	reduce(hull, maxVertices, glm::vec2((float)width, (float)height));
+
+	if ((int)hull.size() > maxVertices || area(hull) > (1.0f - minSavedArea) * width * height)
+		return {};
+
+	for (glm::vec2& v : hull) //to uv space
+		v /= glm::vec2((float)width, (float)height);
+
+	return hull;
+}
+
+std::vector<glm::vec2> SpriteOutline::convexHull(std::vector<glm::vec2>& points) //andrew's monotone chain
+{
+	std::sort(points.begin(), points.end(), [](const glm::vec2& a, const glm::vec2& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+
+	std::vector<glm::vec2> hull(points.size() * 2);
+	size_t k = 0;
+	for (size_t i = 0; i < points.size(); i++) //lower hull
+	{
+		while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0f)
+			k--;
+		hull[k++] = points[i];
+	}
+	for (size_t i = points.size() - 1, t = k + 1; i > 0; i--) //upper hull
+	{
+		while (k >= t && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0.0f)
+			k--;
+		hull[k++] = points[i - 1];
+	}
+
+	hull.resize(k - 1); //last point is the first one
+	return hull;
+}
+
+//removes edges one at a time by extending both neighbouring edges until they meet, the polygon only grows so it still
+//covers every visible texel, the edge that adds the least area goes first
+void SpriteOutline::reduce(std::vector<glm::vec2>& hull, int maxVertices, const glm::vec2& bounds)
+{
+	while ((int)hull.size() > maxVertices)
+	{
+		size_t n = hull.size();
+		size_t bestEdge = n;
+		float bestArea = 0.0f;
+		glm::vec2 bestPoint(0.0f);
+
+		for (size_t i = 0; i < n; i++)
+		{
+			const glm::vec2& prev = hull[(i + n - 1) % n];
+			const glm::vec2& a = hull[i];
+			const glm::vec2& b = hull[(i + 1) % n];
+			const glm::vec2& next = hull[(i + 2) % n];
+
+			glm::vec2 d1 = a - prev;
+			glm::vec2 d2 = b - next;
+			float denom = d1.x * d2.y - d1.y * d2.x;
+			if (denom == 0.0f) //parallel edges never meet
+				continue;
+
+			glm::vec2 diff = next - prev;
+			float t = (diff.x * d2.y - diff.y * d2.x) / denom;
+			if (t <= 1.0f) //edges meet behind the removed edge (polygon would shrink)
+				continue;
+
+			glm::vec2 point = prev + d1 * t;
+			if (point.x < 0.0f || point.y < 0.0f || point.x > bounds.x || point.y > bounds.y) //can't leave the quad
+				continue;
+
+			float addedArea = 0.5f * cross(a, point, b);
+			if (addedArea < 0.0f)
+				addedArea = -addedArea;
+			if (bestEdge == n || addedArea < bestArea)
+			{
+				bestEdge = i;
+				bestArea = addedArea;
+				bestPoint = point;
+			}
+		}
+
+		if (bestEdge == n) //nothing left to remove
+			return;
+
+		hull[bestEdge] = bestPoint;
+		hull.erase(hull.begin() + (bestEdge + 1) % n);
+	}
+}
+
+float SpriteOutline::area(const std::vector<glm::vec2>& polygon)
+{
+	float sum = 0.0f;
+	for (size_t i = 0, n = polygon.size(); i < n; i++)
+		sum += polygon[i].x * polygon[(i + 1) % n].y - polygon[(i + 1) % n].x * polygon[i].y;
+	return 0.5f * (sum < 0.0f ? -sum : sum);
+}
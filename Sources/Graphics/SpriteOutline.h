@@ -0,0 +1,26 @@
+#ifndef SPRITE_OUTLINE_H
+#define SPRITE_OUTLINE_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+//builds a tight convex polygon around the visible (alpha above threshold) texels of an image, so the sprite batch
+//can draw that polygon instead of the full quad and skip the fragments that would be fully transparent anyway
+class SpriteOutline
+{
+public:
+	static const int defaultMaxVertices = 8;
+	static const unsigned char defaultAlphaThreshold = 0;
+
+	//returns the outline in uv space (counter clockwise), or an empty vector if the quad is already tight enough
+	//pixels are expected bottom row first (as loaded with stbi flip on), alpha is the last channel
+	static std::vector<glm::vec2> compute(const unsigned char* pixels, int width, int height, int numberOfChannels,
+		int maxVertices = defaultMaxVertices, unsigned char alphaThreshold = defaultAlphaThreshold);
+
+private:
+	static std::vector<glm::vec2> convexHull(std::vector<glm::vec2>& points);
+	static void reduce(std::vector<glm::vec2>& hull, int maxVertices, const glm::vec2& bounds);
+	static float area(const std::vector<glm::vec2>& polygon);
+};
+
+#endif
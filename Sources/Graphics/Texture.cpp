@@ -1,118 +1,463 @@
 #include "Texture.h"
+#include "SpriteOutline.h"
+#include "TextureLoader.h"
+#include "CookedTexture.h"
+#include "BlockCompression.h"
+#include "TextureStreamer.h"
+#include "TextureResidency.h"
+#include "GLState.h"
+#include "RenderTarget.h"
+#include "ImageDecoder.h"
+#include "../Engine/MappedFile.h"
 
 int Texture::nextFreeID = 1;
 
+static size_t bytesPerTexel(GLenum internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_R8:
+		return 1;
+	case GL_RG8:
+	case GL_DEPTH_COMPONENT16:
+		return 2;
+	case GL_RGBA16F:
+	case GL_DEPTH32F_STENCIL8:
+		return 8;
+	case GL_RGBA32F:
+		return 16;
+	default: //RGB8 is padded to 4 bytes by most drivers
+		return 4;
+	}
+}
+
+size_t ImageData::getByteSize() const
+{
+	if (!levels.empty())
+		return levels.back().offset + levels.back().size;
+	return (size_t)width * height * numberOfChannels;
+}
+
 Texture::Texture()
 {
 	width = 1;
 	height = 1;
 	numberOfChannels = 3;
 	textureID = 0;
-	assignedTexID = 0;
 
 	glGenTextures(1, &textureID);
 
-	glBindTexture(GL_TEXTURE_2D, textureID); //for 2D textures?
-
-	//texture wrapping
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-	//texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); //mipmap option => tex filtering: linear, mipmap: linear between two
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	GLState::bindTexture(textureID); //for 2D textures?
 
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, &color);
+	setResidentBytes(4);
 }
 
-Texture::Texture(const char* name, bool isPng)
+Texture::Texture(const char* name)
 {
 	width = 1;
 	height = 1;
-	numberOfChannels = isPng? 4 : 3;
+	numberOfChannels = 4; //until the image is decoded
 	textureID = 0;
-	assignedTexID = 0;
 
 	glGenTextures(1, &textureID);
 
-	glBindTexture(GL_TEXTURE_2D, textureID); //for 2D textures?
+	GLState::bindTexture(textureID); //for 2D textures?
 
-	//texture wrapping
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	loadTexture(name);
+}
 
-	//texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); //mipmap option => tex filtering: linear, mipmap: linear between two
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+Texture::Texture(int width, int height, GLenum internalFormat)
+{
+	this->width = width;
+	this->height = height;
+	numberOfChannels = 4;
+	isOpaque = false; //whatever gets rendered into it might have alpha
+	textureID = 0;
+
+	glGenTextures(1, &textureID);
 
-	loadTexture(name, isPng);
+	GLState::bindTexture(textureID); //for 2D textures?
+
+	sampler.minFilter = GL_LINEAR; //no mipmaps, contents change every frame
+	sampler.magFilter = GL_LINEAR;
+
+	GLenum format = GL_RGBA;
+	GLenum type = GL_UNSIGNED_BYTE;
+	if (RenderTarget::hasStencil(internalFormat))
+	{
+		format = GL_DEPTH_STENCIL;
+		type = internalFormat == GL_DEPTH24_STENCIL8 ? GL_UNSIGNED_INT_24_8 : GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+	}
+	else if (RenderTarget::isDepthFormat(internalFormat))
+	{
+		format = GL_DEPTH_COMPONENT;
+		type = GL_FLOAT;
+	}
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr); //storage only
+	setResidentBytes((size_t)width * height * bytesPerTexel(internalFormat));
+}
+
+Texture::Texture(Texture&& other) noexcept
+{
+	textureID = 0;
+	*this = std::move(other);
+}
+
+Texture& Texture::operator=(Texture&& other) noexcept
+{
+	if (this != &other)
+	{
+		deleteTexture();
+
+		width = other.width;
+		height = other.height;
+		numberOfChannels = other.numberOfChannels;
+		color = other.color;
+		isOpaque = other.isOpaque;
+		outline = std::move(other.outline);
+		textureID = other.textureID;
+		ready = other.ready;
+		loading = other.loading;
+		evicted = other.evicted;
+		residentBytes = other.residentBytes;
+		storageFormat = other.storageFormat;
+		sampler = other.sampler;
+		samplerObject = other.samplerObject;
+
+		drawScale = other.drawScale;
+		lastUsedFrame = other.lastUsedFrame;
+		sourcePath = std::move(other.sourcePath);
+
+		TextureStreamer::retarget(&other, this);
+		TextureResidency::retarget(&other, this);
+		other.residentBytes = 0;
+		other.textureID = 0; //the moved from texture doesn't own the GL object anymore
+	}
+	return *this;
 }
 
-GLuint Texture::getTexID()
+Texture::Texture(Deferred)
 {
-	return assignedTexID;
+	width = 1;
+	height = 1;
+	numberOfChannels = 4;
+	textureID = 0;
+	ready = false;
 }
 
-void Texture::setTexID(unsigned int texID)
+Texture* Texture::loadAsync(const char* name)
 {
-	assignedTexID = texID;
+	Texture* texture = new Texture(Deferred());
+	texture->sourcePath = name;
+	TextureLoader::load(texture, name);
+	return texture;
+}
+
+bool Texture::reload()
+{
+	if (loading) //the load in flight might have read the old file, try again once it's done
+		return false;
+	if (sourcePath.empty() || evicted) //nothing to read from, or it reads the file again when it comes back anyway
+		return true;
+
+	TextureLoader::load(this, sourcePath.c_str());
+	return true;
+}
+
+bool Texture::isReady() const
+{
+	return ready;
+}
+
+bool Texture::isEvicted() const
+{
+	return evicted;
+}
+
+size_t Texture::getResidentBytes() const
+{
+	return residentBytes;
+}
+
+void Texture::setResidentBytes(size_t bytes)
+{
+	TextureResidency::onResize(this, residentBytes, bytes);
+	residentBytes = bytes;
+}
+
+void Texture::evict()
+{
+	TextureStreamer::untrack(this);
+	glDeleteTextures(1, &textureID);
+	GLState::onTextureDeleted(textureID);
+	textureID = 0;
+	storageFormat = 0;
+	ready = false;
+	evicted = true;
+	setResidentBytes(0);
+}
+
+void Texture::createTextureObject()
+{
+	if (textureID != 0)
+		return;
+
+	glGenTextures(1, &textureID);
+
+	GLState::bindTexture(textureID); //for 2D textures?
+}
+
+GLuint Texture::getGLTexture() const
+{
+	return textureID;
+}
+
+bool Texture::loadTexture(const char* name)
+{
+	sourcePath = name;
+
+	ImageData image;
+	if (!decodeImage(name, image))
+		return false;
+
+	uploadImage(image, image.pixels);
+
+	//free image memory (we don't need it anymore)
+	freeImage(image);
+
+	return true;
 }
 
-bool Texture::loadTexture(const char* name, bool isPng)
+bool Texture::decodeImage(const char* name, ImageData& image)
 {
 	std::string projectPath = std::filesystem::current_path().string();
 	std::replace(projectPath.begin(), projectPath.end(), '\\', '/');
 
-	stbi_set_flip_vertically_on_load(true); //flip images
-	unsigned char* data = stbi_load((projectPath + name).c_str(), &width, &height, &numberOfChannels, 0);
+	if (CookedTexture::isCookedPath(name)) //mips, opacity and outline were computed offline
+		return CookedTexture::read(projectPath + name, image);
 
-	if (data) //error checking
+	if (!ImageDecoder::decode(projectPath + name, image)) //error checking
 	{
-		if(isPng)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data); //note jpg is RGB
-		else
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data); //note jpg is RGB
+		std::cout << "Failed to load texture" << std::endl;
+		return false;
+	}
 
-		glGenerateMipmap(GL_TEXTURE_2D);
+	image.outline.clear();
+	if (!image.isOpaque) //trim the fully transparent area so it isn't rasterized
+		image.outline = SpriteOutline::compute(image.pixels, image.width, image.height, image.numberOfChannels);
+
+	return true;
+}
+
+void Texture::freeImage(ImageData& image)
+{
+	if (image.file || image.storage) //pixels point into the mapping or the storage, freed with the last copy
+	{
+		image.file.reset();
+		image.storage.reset();
 	}
 	else
+		stbi_image_free(image.pixels);
+	image.pixels = nullptr;
+}
+
+//the decoded channel count picks the storage (a grayscale mask takes a quarter of rgba), swizzles make the shader
+//see rgba either way: 1 channel is gray, 2 channels are gray + alpha
+static void selectFormat(int numberOfChannels, GLenum& internalFormat, GLenum& format)
+{
+	static const GLenum internalFormats[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+	static const GLenum formats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+	internalFormat = internalFormats[numberOfChannels - 1];
+	format = formats[numberOfChannels - 1];
+}
+
+static void setSwizzle(int numberOfChannels)
+{
+	static const GLint swizzles[4][4] = {
+		{ GL_RED, GL_RED, GL_RED, GL_ONE },
+		{ GL_RED, GL_RED, GL_RED, GL_GREEN },
+		{ GL_RED, GL_GREEN, GL_BLUE, GL_ONE },
+		{ GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA },
+	};
+	glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzles[numberOfChannels - 1]);
+}
+
+//a reload that changes the texture's shape frees the levels of the old one first, whatever the new upload doesn't
+//overwrite would keep its memory (the coarse levels of a bigger image, the fine ones the streamer holds back)
+static void releaseAllLevels(int width, int height)
+{
+	int levelCount = 1;
+	while ((width >> levelCount) > 0 || (height >> levelCount) > 0)
+		levelCount++;
+
+	for (int i = 0; i < levelCount; i++)
+		glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+}
+
+void Texture::uploadImage(const ImageData& image, const void* pixels, size_t pixelsOffset)
+{
+	bool hasContent = residentBytes > 0; //reloaded in place (hot reload), same GL texture
+	int oldWidth = width;
+	int oldHeight = height;
+
+	width = image.width;
+	height = image.height;
+	numberOfChannels = image.numberOfChannels;
+	isOpaque = image.isOpaque;
+	outline = image.outline;
+
+	GLState::bindTexture(textureID);
+
+	if (!image.levels.empty()) //cooked, only the coarse levels go up now if the streamer takes it, the rest follows on demand
 	{
-		std::cout << "Failed to load texture" << std::endl;
-		return false;
+		if (hasContent)
+		{
+			TextureStreamer::untrack(this);
+			releaseAllLevels(oldWidth, oldHeight);
+		}
+		storageFormat = 0;
+
+		int levelCount = (int)image.levels.size();
+		int firstLevel = TextureStreamer::track(this, image);
+
+		setSwizzle(BlockCompression::isCompressedFormat(image.internalFormat) ? 4 : numberOfChannels);
+		setLevelRange(firstLevel, levelCount - 1);
+		setResidentBytes(0); //uploadLevel adds up the levels
+		for (int i = firstLevel; i < levelCount; i++)
+			uploadLevel(image, i, (const unsigned char*)pixels + (image.levels[i].offset - pixelsOffset));
+		return;
 	}
 
-	//free image memory (we don't need it anymore)
-	stbi_image_free(data);
+	GLenum internalFormat;
+	GLenum format;
+	selectFormat(numberOfChannels, internalFormat, format);
 
-	return true;
+	setSwizzle(numberOfChannels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1); //stb rows are tightly packed, 1 and 3 channel rows aren't 4 byte aligned
+	if (hasContent && storageFormat == internalFormat && oldWidth == width && oldHeight == height) //same storage, only the texels change
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, pixels);
+	else
+	{
+		if (hasContent)
+		{
+			TextureStreamer::untrack(this); //it was cooked before
+			releaseAllLevels(oldWidth, oldHeight);
+		}
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+		storageFormat = internalFormat;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glGenerateMipmap(GL_TEXTURE_2D);
+	setResidentBytes((size_t)width * height * bytesPerTexel(internalFormat) * 4 / 3); //the generated chain adds a third
 }
 
-void Texture::setTextureWrapping(int textureWrapH, int textureWrapV)
+void Texture::uploadLevel(const ImageData& image, int level, const void* pixels)
+{
+	const ImageLevel& imageLevel = image.levels[level];
+	GLState::bindTexture(textureID);
+	setResidentBytes(residentBytes + imageLevel.size);
+
+	if (BlockCompression::isCompressedFormat(image.internalFormat)) //blocks go to the gpu as they are
+	{
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, image.internalFormat, imageLevel.width, imageLevel.height, 0, (GLsizei)imageLevel.size, pixels);
+		return;
+	}
+
+	GLenum internalFormat;
+	GLenum format;
+	selectFormat(image.numberOfChannels, internalFormat, format);
+	if (image.internalFormat != 0) //cooked with an explicit format
+		internalFormat = image.internalFormat;
+
+	//allocate, then fill
+	glTexImage2D(GL_TEXTURE_2D, level, internalFormat, imageLevel.width, imageLevel.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1); //cooked levels are tightly packed
+	glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, imageLevel.width, imageLevel.height, format, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void Texture::releaseLevel(const ImageData& image, int level)
+{
+	GLState::bindTexture(textureID);
+	setResidentBytes(residentBytes - std::min(residentBytes, image.levels[level].size));
+
+	//respecifying as 0x0 frees the storage, the texture stays complete as long as the level is below the base level
+	if (BlockCompression::isCompressedFormat(image.internalFormat))
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, image.internalFormat, 0, 0, 0, 0, nullptr);
+	else
+	{
+		GLenum internalFormat;
+		GLenum format;
+		selectFormat(image.numberOfChannels, internalFormat, format);
+		glTexImage2D(GL_TEXTURE_2D, level, image.internalFormat != 0 ? image.internalFormat : internalFormat, 0, 0, 0, format, GL_UNSIGNED_BYTE, nullptr);
+	}
+}
+
+void Texture::setLevelRange(int baseLevel, int maxLevel)
 {
-	glBindTexture(GL_TEXTURE_2D, textureID); //for 2D textures?
+	GLState::bindTexture(textureID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, baseLevel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+}
 
-	//texture wrapping
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, textureWrapH);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, textureWrapV);
+void Texture::setTextureWrapping(int textureWrapH, int textureWrapV)
+{
+	sampler.wrapS = textureWrapH;
+	sampler.wrapT = textureWrapV;
+	samplerObject = 0; //looked up again on the next use
 }
 
 void Texture::setTextureFiltering(int minFilter, int maxFilter)
 {
-	glBindTexture(GL_TEXTURE_2D, textureID); //for 2D textures?
+	sampler.minFilter = minFilter; //mipmap option => tex filtering: linear, mipmap: linear between two
+	sampler.magFilter = maxFilter;
+	samplerObject = 0;
+}
+
+void Texture::setAnisotropy(float anisotropy)
+{
+	sampler.anisotropy = anisotropy;
+	samplerObject = 0;
+}
+
+const SamplerDesc& Texture::getSamplerDesc() const
+{
+	return sampler;
+}
 
-	//texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter); //mipmap option => tex filtering: linear, mipmap: linear between two
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, maxFilter);
+GLuint Texture::getSampler()
+{
+	if (samplerObject == 0)
+		samplerObject = SamplerCache::get(sampler);
+	return samplerObject;
 }
 
 void Texture::bindTexture()
 {
-	glBindTexture(GL_TEXTURE_2D, textureID); //for 2D textures?
+	GLState::bindTexture(textureID); //for 2D textures?
+}
+
+void Texture::bindTexture(unsigned int unit)
+{
+	GLState::bindTexture(unit, textureID);
+	GLState::bindSampler(unit, getSampler());
 }
 
 void Texture::deleteTexture() //don't call this unless you won't use it anymore
 {
+	TextureResidency::untrack(this);
+	residentBytes = 0;
+
+	if (textureID == 0) //never created, moved from or deleted already
+		return;
+
+	TextureStreamer::untrack(this);
 	glDeleteTextures(1, &textureID);
+	GLState::onTextureDeleted(textureID);
+	textureID = 0;
+	storageFormat = 0;
 } 
 
 Texture::~Texture()
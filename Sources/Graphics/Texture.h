@@ -6,6 +6,37 @@
 #include "stb_image.h"
 #include <filesystem>
 #include <glm/glm.hpp>
+#include "SamplerCache.h"
+#include <vector>
+#include <memory>
+#include <string>
+
+class MappedFile;
+
+struct ImageLevel
+{
+	int width;
+	int height;
+	size_t offset; //from ImageData::pixels
+	size_t size;
+};
+
+//decoded pixels, produced on any thread and uploaded on the GL thread
+struct ImageData
+{
+	unsigned char* pixels = nullptr; //owned by stb_image or pointing into file or storage, release with Texture::freeImage
+	int width = 0;
+	int height = 0;
+	int numberOfChannels = 0;
+	bool isOpaque = true;
+	std::vector<glm::vec2> outline;
+	std::vector<ImageLevel> levels; //pre-built mip chain of a cooked texture, empty means mips are generated on upload
+	GLenum internalFormat = 0; //set by cooked textures, can be a block compressed format
+	std::shared_ptr<MappedFile> file; //keeps the cooked file mapped while pixels point into it
+	std::shared_ptr<std::vector<unsigned char>> storage; //pixels converted at load time (compressed formats the driver lacks), shared by copies like file
+
+	size_t getByteSize() const; //all levels
+};
 
 class Texture
 {
@@ -16,20 +47,71 @@ public:
 	int height;
 	int numberOfChannels;
 	unsigned int color = 0xffffffff;
+	bool isOpaque = true; //no texel has alpha below 255, the sprite batch can draw it without blending
+	std::vector<glm::vec2> outline; //tight convex polygon (uv space) around the visible texels, empty means draw the full quad
+
+	//usage, written by the sprite batch through TextureStreamer::noteUse
+	float drawScale = 0.0f; //largest world size per texel it was drawn with this frame
+	unsigned int lastUsedFrame = 0;
+	std::string sourcePath; //what an evicted texture reloads from, empty for textures made in code (never evicted)
 
 	Texture();
-	Texture(const char* name, bool isPng);
-	GLuint getTexID();
-	void setTexID(unsigned int texID);
-	bool loadTexture(const char* name, bool isPng);
+	explicit Texture(const char* name); //the storage format follows the decoded channels
+	Texture(int width, int height, GLenum internalFormat); //empty texture, used as a render target
+	Texture(const Texture&) = delete; //one owner per GL object, share through TextureCache handles instead
+	Texture& operator=(const Texture&) = delete;
+	Texture(Texture&& other) noexcept;
+	Texture& operator=(Texture&& other) noexcept;
+	//decodes on the worker pool and uploads through TextureLoader, the returned texture isn't ready until then
+	//(the sprite batch draws the white texture in its place), don't delete it before it's ready or the loader shut down
+	static Texture* loadAsync(const char* name);
+	//GL thread, decodes sourcePath again and re-uploads into the same GL texture (hot reload), the old pixels are drawn
+	//until the new ones are on the gpu, false when a load is in flight already (call again later)
+	bool reload();
+	bool isReady() const;
+	bool isEvicted() const;
+	size_t getResidentBytes() const; //gpu memory of all resident levels (estimated for generated mips)
+	GLuint getGLTexture() const; //the OpenGL texture object
+	bool loadTexture(const char* name);
+	static bool decodeImage(const char* name, ImageData& image); //no GL calls, safe on any thread
+	static void freeImage(ImageData& image);
+	//pixels is an offset when a pixel unpack buffer is bound, pixelsOffset says where in the image it starts (cooked
+	//images can be handed over without the levels the streamer keeps off the gpu, see TextureStreamer::getInitialLevel)
+	void uploadImage(const ImageData& image, const void* pixels, size_t pixelsOffset = 0);
+	void createTextureObject(); //for textures made by loadAsync, does nothing if the GL object exists already
+	//sampling settings live in a shared sampler object (SamplerCache), these don't touch the GL texture
 	void setTextureWrapping(int textureWrapH, int textureWrapV);
 	void setTextureFiltering(int minFilter, int maxFilter);
+	void setAnisotropy(float anisotropy);
+	const SamplerDesc& getSamplerDesc() const;
+	GLuint getSampler(); //GL thread
 	void bindTexture();
+	void bindTexture(unsigned int unit); //texture and its sampler
 	void deleteTexture();
 	~Texture();
 private:
+	friend class TextureLoader;
+	friend class TextureStreamer;
+	friend class TextureResidency;
+
+	void uploadLevel(const ImageData& image, int level, const void* pixels); //one level of a cooked image
+	void releaseLevel(const ImageData& image, int level); //frees the storage of a level outside the base/max range
+	void setLevelRange(int baseLevel, int maxLevel);
+	void setResidentBytes(size_t bytes);
+	void evict(); //frees the GL texture, it gets reloaded from sourcePath the next time it's drawn
+
+	struct Deferred {};
+	Texture(Deferred); //no GL object yet, the loader creates it on the GL thread
+
 	unsigned int textureID;
-	unsigned int assignedTexID;
+	bool ready = true;
+	bool loading = false; //queued in TextureLoader
+	bool evicted = false;
+	size_t residentBytes = 0;
+	GLenum storageFormat = 0; //of level 0 when it was uploaded with generated mips, a reload of the same size updates it in place
+
+	SamplerDesc sampler;
+	GLuint samplerObject = 0; //cached SamplerCache::get(sampler)
 };
 
 #endif
@@ -0,0 +1,381 @@
+#include "TextureAtlas.h"
+#include "BlockCompression.h"
+#include "GLState.h"
+#include "ImageDecoder.h"
+#include <algorithm>
+#include <climits>
+#include <unordered_map>
+
+static const int padding = 1; //edge texels are repeated around every region so filtering doesn't pick up the neighbours
+static const float minDefragFill = 0.25f; //pages packed less than this aren't worth repacking
+
+struct SkylineNode
+{
+	int x;
+	int y; //top of the packed area over [x, x + width)
+	int width;
+};
+
+struct AtlasPage
+{
+	Texture* texture;
+	int size;
+	std::vector<SkylineNode> skyline;
+	size_t liveArea = 0; //padded area of the regions still in use
+	unsigned int regionCount = 0;
+};
+
+struct AtlasEntry
+{
+	TextureAtlas::Region region;
+	unsigned int page;
+	int x; //padded rect in the page
+	int y;
+};
+
+struct AtlasData
+{
+	int pageSize = 2048;
+	float defragThreshold = 0.5f;
+	std::vector<AtlasPage> pages;
+	std::unordered_map<TextureAtlas::Handle, AtlasEntry> entries;
+	TextureAtlas::Handle nextHandle = 1;
+	GLuint readFramebuffer = 0; //for copying regions between pages
+	GLuint drawFramebuffer = 0;
+	std::vector<unsigned char> scratch;
+	TextureAtlas::Stats stats = {};
+};
+
+static AtlasData aData;
+
+//bottom-left rule: the lowest spot the rect fits in, ties go to the narrowest skyline segment
+static bool packSkyline(std::vector<SkylineNode>& skyline, int pageSize, int width, int height, int& x, int& y)
+{
+	size_t bestIndex = skyline.size();
+	int bestY = INT_MAX;
+	int bestWidth = INT_MAX;
+
+	for (size_t i = 0; i < skyline.size(); i++)
+	{
+		if (skyline[i].x + width > pageSize)
+			break;
+
+		//the rect rests on the highest segment it spans
+		int top = 0;
+		int remaining = width;
+		for (size_t j = i; remaining > 0; j++)
+		{
+			top = std::max(top, skyline[j].y);
+			remaining -= skyline[j].width;
+		}
+
+		if (top + height > pageSize)
+			continue;
+		if (top < bestY || (top == bestY && skyline[i].width < bestWidth))
+		{
+			bestIndex = i;
+			bestY = top;
+			bestWidth = skyline[i].width;
+		}
+	}
+
+	if (bestIndex == skyline.size())
+		return false;
+
+	x = skyline[bestIndex].x;
+	y = bestY;
+	skyline.insert(skyline.begin() + bestIndex, { x, y + height, width });
+
+	//the segments under the new one shrink or go away
+	for (size_t i = bestIndex + 1; i < skyline.size();)
+	{
+		int covered = skyline[i - 1].x + skyline[i - 1].width - skyline[i].x;
+		if (covered <= 0)
+			break;
+
+		skyline[i].x += covered;
+		skyline[i].width -= covered;
+		if (skyline[i].width > 0)
+			break;
+		skyline.erase(skyline.begin() + i);
+	}
+
+	for (size_t i = 0; i + 1 < skyline.size();)
+	{
+		if (skyline[i].y == skyline[i + 1].y)
+		{
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else
+			i++;
+	}
+
+	return true;
+}
+
+//everything under the skyline, holes included
+static size_t packedArea(const AtlasPage& page)
+{
+	size_t area = 0;
+	for (const SkylineNode& node : page.skyline)
+		area += (size_t)node.width * node.y;
+	return area;
+}
+
+static float fragmentation(const AtlasPage& page)
+{
+	size_t area = packedArea(page);
+	return area == 0 ? 0.0f : 1.0f - (float)page.liveArea / area;
+}
+
+static Texture* createPageTexture(int size)
+{
+	Texture* texture = new Texture(size, size, GL_RGBA8);
+	texture->setTextureFiltering(GL_NEAREST, GL_NEAREST); //same as loaded textures, the padding keeps linear usable too
+	return texture;
+}
+
+static void setRegionRect(AtlasEntry& entry, const AtlasPage& page, int x, int y)
+{
+	entry.x = x;
+	entry.y = y;
+	entry.region.texture = page.texture;
+	float size = (float)page.size;
+	entry.region.uvRect = glm::vec4((x + padding) / size, (y + padding) / size, (x + padding + entry.region.width) / size, (y + padding + entry.region.height) / size);
+}
+
+void TextureAtlas::setPageSize(int size)
+{
+	aData.pageSize = size;
+}
+
+void TextureAtlas::setDefragThreshold(float fraction)
+{
+	aData.defragThreshold = fraction;
+}
+
+//decoded images are premultiplied already, pixels from elsewhere still have straight alpha
+static TextureAtlas::Handle addPixels(const unsigned char* pixels, int width, int height, int numberOfChannels, bool isPremultiplied)
+{
+	if (pixels == nullptr || width <= 0 || height <= 0 || numberOfChannels < 1 || numberOfChannels > 4)
+		return 0;
+
+	int paddedWidth = width + 2 * padding;
+	int paddedHeight = height + 2 * padding;
+
+	//first page with room, or a new one
+	unsigned int pageIndex = 0;
+	int x = 0, y = 0;
+	for (; pageIndex < aData.pages.size(); pageIndex++)
+		if (packSkyline(aData.pages[pageIndex].skyline, aData.pages[pageIndex].size, paddedWidth, paddedHeight, x, y))
+			break;
+
+	if (pageIndex == aData.pages.size())
+	{
+		GLint maxSize;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+		int size = std::min(aData.pageSize, (int)maxSize);
+		if (paddedWidth > size || paddedHeight > size)
+		{
+			std::cout << "ERROR::TEXTURE_ATLAS::IMAGE_LARGER_THAN_PAGE" << std::endl;
+			return 0;
+		}
+
+		AtlasPage page;
+		page.size = size;
+		page.texture = createPageTexture(size);
+		page.skyline.push_back({ 0, 0, size });
+		packSkyline(page.skyline, size, paddedWidth, paddedHeight, x, y);
+		aData.pages.push_back(page);
+		aData.stats.pageCount++;
+	}
+
+	//expand to rgba (same swizzles as Texture) with the edges repeated into the padding
+	aData.scratch.resize((size_t)paddedWidth * paddedHeight * 4);
+	bool isOpaque = true;
+	for (int row = 0; row < paddedHeight; row++)
+	{
+		int sourceRow = std::clamp(row - padding, 0, height - 1);
+		for (int column = 0; column < paddedWidth; column++)
+		{
+			int sourceColumn = std::clamp(column - padding, 0, width - 1);
+			const unsigned char* source = pixels + ((size_t)sourceRow * width + sourceColumn) * numberOfChannels;
+			unsigned char* target = &aData.scratch[((size_t)row * paddedWidth + column) * 4];
+
+			if (numberOfChannels < 3)
+			{
+				target[0] = target[1] = target[2] = source[0];
+				target[3] = numberOfChannels == 2 ? source[1] : 255;
+			}
+			else
+			{
+				target[0] = source[0];
+				target[1] = source[1];
+				target[2] = source[2];
+				target[3] = numberOfChannels == 4 ? source[3] : 255;
+			}
+			isOpaque = isOpaque && target[3] == 255;
+		}
+	}
+	if (!isPremultiplied && !isOpaque) //the sprite batch blends premultiplied
+		ImageDecoder::premultiply(aData.scratch.data(), (size_t)paddedWidth * paddedHeight, 4);
+
+	AtlasPage& page = aData.pages[pageIndex];
+	GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	GLState::bindTexture(page.texture->getGLTexture());
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, aData.scratch.data());
+
+	page.liveArea += (size_t)paddedWidth * paddedHeight;
+	page.regionCount++;
+
+	AtlasEntry entry;
+	entry.page = pageIndex;
+	entry.region.width = width;
+	entry.region.height = height;
+	entry.region.isOpaque = isOpaque;
+	setRegionRect(entry, page, x, y);
+
+	TextureAtlas::Handle handle = aData.nextHandle++;
+	aData.entries[handle] = entry;
+	aData.stats.regionCount++;
+	return handle;
+}
+
+TextureAtlas::Handle TextureAtlas::add(const unsigned char* pixels, int width, int height, int numberOfChannels)
+{
+	return addPixels(pixels, width, height, numberOfChannels, false);
+}
+
+TextureAtlas::Handle TextureAtlas::add(const ImageData& image)
+{
+	if (BlockCompression::isCompressedFormat(image.internalFormat))
+	{
+		std::cout << "ERROR::TEXTURE_ATLAS::COMPRESSED_IMAGE" << std::endl;
+		return 0;
+	}
+
+	const unsigned char* pixels = image.levels.empty() ? image.pixels : image.pixels + image.levels[0].offset;
+	return addPixels(pixels, image.width, image.height, image.numberOfChannels, true);
+}
+
+TextureAtlas::Handle TextureAtlas::add(const char* name)
+{
+	ImageData image;
+	if (!Texture::decodeImage(name, image))
+		return 0;
+
+	Handle handle = add(image);
+	Texture::freeImage(image);
+	return handle;
+}
+
+void TextureAtlas::remove(Handle handle)
+{
+	auto it = aData.entries.find(handle);
+	if (it == aData.entries.end())
+		return;
+
+	AtlasPage& page = aData.pages[it->second.page];
+	page.liveArea -= (size_t)(it->second.region.width + 2 * padding) * (it->second.region.height + 2 * padding);
+	page.regionCount--;
+	if (page.regionCount == 0) //empty, start over
+		page.skyline.assign(1, { 0, 0, page.size });
+
+	aData.entries.erase(it);
+	aData.stats.regionCount--;
+}
+
+const TextureAtlas::Region* TextureAtlas::get(Handle handle)
+{
+	auto it = aData.entries.find(handle);
+	return it == aData.entries.end() ? nullptr : &it->second.region;
+}
+
+//packs the live regions again, tallest first, into a fresh texture and copies them over on the gpu
+static bool repack(unsigned int pageIndex)
+{
+	AtlasPage& page = aData.pages[pageIndex];
+
+	std::vector<AtlasEntry*> regions;
+	for (auto& entry : aData.entries)
+		if (entry.second.page == pageIndex)
+			regions.push_back(&entry.second);
+	std::sort(regions.begin(), regions.end(), [](const AtlasEntry* a, const AtlasEntry* b)
+		{
+			return a->region.height != b->region.height ? a->region.height > b->region.height : a->region.width > b->region.width;
+		});
+
+	std::vector<SkylineNode> skyline(1, { 0, 0, page.size });
+	std::vector<glm::ivec2> positions(regions.size());
+	for (size_t i = 0; i < regions.size(); i++)
+		if (!packSkyline(skyline, page.size, regions[i]->region.width + 2 * padding, regions[i]->region.height + 2 * padding, positions[i].x, positions[i].y))
+			return false; //the old layout happened to be tighter, keep it
+
+	Texture* texture = createPageTexture(page.size);
+
+	if (aData.readFramebuffer == 0)
+	{
+		glGenFramebuffers(1, &aData.readFramebuffer);
+		glGenFramebuffers(1, &aData.drawFramebuffer);
+	}
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, aData.readFramebuffer);
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, page.texture->getGLTexture(), 0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, aData.drawFramebuffer);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->getGLTexture(), 0);
+
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		AtlasEntry& entry = *regions[i];
+		int width = entry.region.width + 2 * padding;
+		int height = entry.region.height + 2 * padding;
+		glBlitFramebuffer(entry.x, entry.y, entry.x + width, entry.y + height, positions[i].x, positions[i].y, positions[i].x + width, positions[i].y + height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	delete page.texture;
+	page.texture = texture;
+	page.skyline = skyline;
+	for (size_t i = 0; i < regions.size(); i++)
+		setRegionRect(*regions[i], page, positions[i].x, positions[i].y);
+	return true;
+}
+
+void TextureAtlas::update()
+{
+	aData.stats.fragmentation = 0.0f;
+	for (unsigned int i = 0; i < aData.pages.size(); i++)
+	{
+		const AtlasPage& page = aData.pages[i];
+		float pageFragmentation = fragmentation(page);
+		bool worthIt = packedArea(page) >= (size_t)(minDefragFill * page.size * page.size);
+		if (pageFragmentation > aData.defragThreshold && worthIt && repack(i))
+		{
+			aData.stats.defragCount++;
+			pageFragmentation = fragmentation(aData.pages[i]);
+		}
+		aData.stats.fragmentation = std::max(aData.stats.fragmentation, pageFragmentation);
+	}
+}
+
+void TextureAtlas::shutDown()
+{
+	for (AtlasPage& page : aData.pages)
+		delete page.texture;
+	aData.pages.clear();
+	aData.entries.clear();
+
+	if (aData.readFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &aData.readFramebuffer);
+		glDeleteFramebuffers(1, &aData.drawFramebuffer);
+		aData.readFramebuffer = 0;
+		aData.drawFramebuffer = 0;
+	}
+	aData.stats = {};
+}
+
+const TextureAtlas::Stats& TextureAtlas::getStats()
+{
+	return aData.stats;
+}
@@ -0,0 +1,49 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include "Texture.h"
+
+//packs small runtime images (generated glyphs, user content...) into a few big RGBA pages with a skyline packer,
+//so sprites using them share a texture and stay in the same batch
+//removed images leave holes, pages that get too fragmented are repacked on the gpu in update()
+//regions move when that happens, so keep the handle and look the region up when drawing
+class TextureAtlas
+{
+public:
+	typedef unsigned int Handle; //0 is never a valid handle
+
+	struct Region
+	{
+		Texture* texture; //the page
+		glm::vec4 uvRect; //min u, min v, max u, max v
+		int width;
+		int height;
+		bool isOpaque;
+	};
+
+	static void setPageSize(int size); //for pages created from now on, clamped to GL_MAX_TEXTURE_SIZE
+	static void setDefragThreshold(float fraction); //share of a page's packed area that's holes before it's repacked
+
+	//GL thread, pixels are rows bottom to top like the decoded images, 1 to 4 channels with straight alpha (it's premultiplied here)
+	static Handle add(const unsigned char* pixels, int width, int height, int numberOfChannels);
+	static Handle add(const ImageData& image); //uncompressed only, cooked images add their first level
+	static Handle add(const char* name); //decodes right away
+	static void remove(Handle handle);
+	static const Region* get(Handle handle); //nullptr if removed, valid until the next add, remove or update
+
+	static void update(); //GL thread, between frames (after the sprite batch flushed), repacks fragmented pages
+	static void shutDown();
+
+	//stats
+	struct Stats
+	{
+		unsigned int pageCount;
+		unsigned int regionCount;
+		unsigned int defragCount; //pages repacked so far
+		float fragmentation; //worst page
+	};
+
+	static const Stats& getStats();
+};
+
+#endif
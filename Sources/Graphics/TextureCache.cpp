@@ -0,0 +1,138 @@
+#include "TextureCache.h"
+#include "TextureLoader.h"
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+struct CacheEntry
+{
+	std::string path; //to tell hash collisions apart
+	std::weak_ptr<Texture> texture;
+};
+
+struct CacheData
+{
+	std::mutex mutex;
+	std::unordered_map<uint64_t, CacheEntry> entries;
+	TextureCache::Stats stats = {};
+};
+
+static CacheData cData;
+
+static uint64_t hashPath(const std::string& path) //FNV-1a
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (char c : path)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static void destroyTexture(Texture* texture, uint64_t key)
+{
+	{
+		std::lock_guard<std::mutex> lock(cData.mutex);
+		auto it = cData.entries.find(key);
+		if (it != cData.entries.end() && it->second.texture.expired()) //a reload might have replaced the entry already
+		{
+			cData.entries.erase(it);
+			cData.stats.liveCount--;
+		}
+	}
+
+	TextureLoader::releaseFromAnyThread(texture); //the last handle can go away on the game thread or a worker
+}
+
+static TextureHandle find(uint64_t key, const std::string& path)
+{
+	auto it = cData.entries.find(key);
+	if (it == cData.entries.end())
+		return nullptr;
+
+	if (it->second.path != path)
+	{
+		std::cout << "ERROR::TEXTURE_CACHE::HASH_COLLISION " << path << " " << it->second.path << std::endl;
+		return nullptr;
+	}
+
+	return it->second.texture.lock();
+}
+
+static TextureHandle insert(Texture* texture, uint64_t key, const std::string& path)
+{
+	TextureHandle handle(texture, [key](Texture* texture) { destroyTexture(texture, key); });
+
+	auto it = cData.entries.find(key);
+	if (it == cData.entries.end()) //a collision keeps the first texture cached, the second one is just not shared
+	{
+		cData.entries[key] = { path, handle };
+		cData.stats.liveCount++;
+	}
+	else if (it->second.texture.expired()) //its deleter hasn't run yet
+		it->second.texture = handle;
+
+	cData.stats.missCount++;
+	return handle;
+}
+
+std::string TextureCache::normalizePath(const char* name)
+{
+	std::string path = std::filesystem::path(name).lexically_normal().generic_string(); //"a/./b/../c.png" and "a\\c.png" are "a/c.png"
+	return path;
+}
+
+TextureHandle TextureCache::get(const char* name)
+{
+	std::string path = normalizePath(name);
+	uint64_t key = hashPath(path);
+
+	std::lock_guard<std::mutex> lock(cData.mutex);
+	return find(key, path);
+}
+
+TextureHandle TextureCache::load(const char* name)
+{
+	std::string path = normalizePath(name);
+	uint64_t key = hashPath(path);
+
+	std::lock_guard<std::mutex> lock(cData.mutex);
+	if (TextureHandle handle = find(key, path))
+	{
+		cData.stats.hitCount++;
+		return handle;
+	}
+
+	return insert(new Texture(path.c_str()), key, path);
+}
+
+TextureHandle TextureCache::loadAsync(const char* name)
+{
+	std::string path = normalizePath(name);
+	uint64_t key = hashPath(path);
+
+	std::lock_guard<std::mutex> lock(cData.mutex);
+	if (TextureHandle handle = find(key, path))
+	{
+		cData.stats.hitCount++;
+		return handle;
+	}
+
+	return insert(Texture::loadAsync(path.c_str()), key, path);
+}
+
+void TextureCache::shutDown()
+{
+	std::lock_guard<std::mutex> lock(cData.mutex);
+	for (auto& entry : cData.entries)
+		if (!entry.second.texture.expired())
+			std::cout << "ERROR::TEXTURE_CACHE::TEXTURE_STILL_REFERENCED " << entry.second.path << std::endl;
+	cData.entries.clear();
+	cData.stats.liveCount = 0;
+}
+
+const TextureCache::Stats& TextureCache::getStats()
+{
+	return cData.stats;
+}
@@ -0,0 +1,34 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include "Texture.h"
+#include <memory>
+#include <string>
+
+typedef std::shared_ptr<Texture> TextureHandle;
+
+//hands out shared handles so every user of an image gets the same texture, keyed by the hash of the normalized path
+//the texture is deleted once the last handle goes away: right there on the render thread, on its next TextureLoader::update
+//when the handle was dropped on another thread
+class TextureCache
+{
+public:
+	static TextureHandle load(const char* name); //GL thread, decodes and uploads right away on a miss
+	static TextureHandle loadAsync(const char* name); //any thread, see Texture::loadAsync
+	static TextureHandle get(const char* name); //any thread, the cached texture if something still holds it, never loads
+	static void shutDown(); //reports handles that are still alive
+
+	static std::string normalizePath(const char* name);
+
+	//stats
+	struct Stats
+	{
+		unsigned int hitCount; //loads served by an existing texture
+		unsigned int missCount; //loads that created a texture
+		unsigned int liveCount; //textures currently cached
+	};
+
+	static const Stats& getStats();
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "TextureCooker.h"
+#include "CookedTexture.h"
+#include "BlockCompression.h"
+#include <algorithm>
+#include <cstring>
+
+//2x2 box filter, odd edges repeat the last texel
+static void downsample(const unsigned char* source, int sourceWidth, int sourceHeight, int channels, unsigned char* target, int targetWidth, int targetHeight)
+{
+	for (int y = 0; y < targetHeight; y++)
+	{
+		int y0 = std::min(y * 2, sourceHeight - 1);
+		int y1 = std::min(y * 2 + 1, sourceHeight - 1);
+		for (int x = 0; x < targetWidth; x++)
+		{
+			int x0 = std::min(x * 2, sourceWidth - 1);
+			int x1 = std::min(x * 2 + 1, sourceWidth - 1);
+			for (int c = 0; c < channels; c++)
+			{
+				unsigned int sum = source[((size_t)y0 * sourceWidth + x0) * channels + c] + source[((size_t)y0 * sourceWidth + x1) * channels + c]
+					+ source[((size_t)y1 * sourceWidth + x0) * channels + c] + source[((size_t)y1 * sourceWidth + x1) * channels + c];
+				target[((size_t)y * targetWidth + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+bool TextureCooker::parseFormat(const char* name, Format& format)
+{
+	static const char* names[] = { "auto", "raw", "bc1", "bc3" };
+	for (int i = 0; i < 4; i++)
+		if (strcmp(name, names[i]) == 0)
+		{
+			format = (Format)i;
+			return true;
+		}
+
+	std::cout << "ERROR::TEXTURE_COOKER::UNKNOWN_FORMAT " << name << " (auto, raw, bc1 or bc3)" << std::endl;
+	return false;
+}
+
+bool TextureCooker::cook(const char* inputName, const char* outputName, Format format)
+{
+	ImageData image;
+	if (!Texture::decodeImage(inputName, image))
+		return false;
+
+	//level 0 as decoded, then halve until 1x1
+	std::vector<unsigned char> levelData(image.pixels, image.pixels + image.getByteSize());
+	image.levels.push_back({ image.width, image.height, 0, levelData.size() });
+	while (image.levels.back().width > 1 || image.levels.back().height > 1)
+	{
+		ImageLevel source = image.levels.back();
+		ImageLevel target = { std::max(source.width / 2, 1), std::max(source.height / 2, 1), levelData.size(), 0 };
+		target.size = (size_t)target.width * target.height * image.numberOfChannels;
+
+		levelData.resize(levelData.size() + target.size);
+		downsample(levelData.data() + source.offset, source.width, source.height, image.numberOfChannels, levelData.data() + target.offset, target.width, target.height);
+		image.levels.push_back(target);
+	}
+
+	Texture::freeImage(image);
+
+	if (format == Auto) //masks and 2 channel images stay small uncompressed, there's no BC4/BC5 encoder
+		format = image.numberOfChannels < 3 ? Uncompressed : image.isOpaque ? BC1 : BC3;
+
+	if (format != Uncompressed)
+	{
+		image.internalFormat = format == BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+		std::vector<unsigned char> blockData;
+		for (ImageLevel& level : image.levels)
+		{
+			std::vector<unsigned char> blocks = BlockCompression::compress(levelData.data() + level.offset, level.width, level.height, image.numberOfChannels, image.internalFormat);
+			level.offset = blockData.size();
+			level.size = blocks.size();
+			blockData.insert(blockData.end(), blocks.begin(), blocks.end());
+		}
+		levelData = std::move(blockData);
+	}
+
+	std::string projectPath = std::filesystem::current_path().string();
+	std::replace(projectPath.begin(), projectPath.end(), '\\', '/');
+	if (!CookedTexture::write(projectPath + outputName, image, levelData))
+		return false;
+
+	std::cout << "cooked " << inputName << " -> " << outputName << ": " << image.width << "x" << image.height << ", "
+		<< image.numberOfChannels << " channels, " << image.levels.size() << " levels, " << (format == Uncompressed ? "raw" : format == BC1 ? "bc1" : "bc3")
+		<< ", " << levelData.size() << " bytes" << std::endl;
+	return true;
+}
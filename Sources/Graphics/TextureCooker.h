@@ -0,0 +1,21 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+//offline step turning a png/jpg into a .gtex (see CookedTexture), run the engine with --cook <input> <output> [format]
+//paths are relative to the project like every other asset path
+class TextureCooker
+{
+public:
+	enum Format
+	{
+		Auto, //BC1 for opaque images, BC3 if they have alpha, 1 and 2 channel images stay uncompressed
+		Uncompressed,
+		BC1,
+		BC3,
+	};
+
+	static bool parseFormat(const char* name, Format& format); //auto, raw, bc1 or bc3
+	static bool cook(const char* inputName, const char* outputName, Format format = Auto);
+};
+
+#endif
@@ -0,0 +1,324 @@
+#include "TextureLoader.h"
+#include "GLState.h"
+#include "TextureStreamer.h"
+#include "RenderThread.h"
+#include "../Engine/ThreadPool.h"
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+
+static const size_t maxUploadBytesPerFrame = 8 * 1024 * 1024; //spreads big batches over several frames, at least one image goes each frame
+
+struct DecodedTexture
+{
+	Texture* texture;
+	ImageData image;
+};
+
+//mapped pixel buffer a worker is copying the image into, the GL thread never touches the pixels itself
+struct FillingUpload
+{
+	Texture* texture;
+	ImageData image;
+	GLuint pixelBuffer;
+	size_t offset; //where in the image the copied data starts (cooked textures skip the levels the streamer holds back)
+	size_t size;
+	std::atomic<bool> filled{ false };
+};
+
+struct PendingUpload
+{
+	Texture* texture;
+	GLuint pixelBuffer;
+	GLsync fence;
+};
+
+struct LoaderData
+{
+	std::mutex decodedMutex;
+	std::vector<DecodedTexture> decoded; //filled by the workers, drained by update
+	std::atomic<unsigned int> decodingCount{ 0 };
+
+	std::vector<std::unique_ptr<FillingUpload>> filling; //stable addresses, the workers hold pointers
+	std::vector<PendingUpload> uploads;
+	std::vector<GLuint> freePixelBuffers;
+
+	std::vector<Texture*> released; //owners let go while they were still loading
+
+	std::mutex pendingReleaseMutex;
+	std::vector<Texture*> pendingReleases; //let go off the GL thread, released by the next update
+
+	TextureLoader::Stats stats = {};
+};
+
+static LoaderData lData;
+
+//what actually has to reach the gpu now
+static void uploadRange(const ImageData& image, size_t& offset, size_t& size)
+{
+	offset = image.levels.empty() ? 0 : image.levels[TextureStreamer::getInitialLevel(image)].offset;
+	size = image.getByteSize() - offset;
+}
+
+//maps a pixel buffer and has a worker copy the image into it, the copy out of a mapped cooked file page faults on
+//the worker instead of stalling the GL thread, and the next file is read while the previous one is still uploading
+static void startFill(DecodedTexture& item)
+{
+	size_t offset, size;
+	uploadRange(item.image, offset, size);
+
+	GLuint pixelBuffer;
+	if (lData.freePixelBuffers.empty())
+		glGenBuffers(1, &pixelBuffer);
+	else
+	{
+		pixelBuffer = lData.freePixelBuffers.back();
+		lData.freePixelBuffers.pop_back();
+	}
+
+	GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW); //orphan, the buffer might still be read by an older upload
+	unsigned char* mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (mapped == nullptr) //mapping failed, upload straight from client memory
+	{
+		std::cout << "ERROR::TEXTURE_LOADER::PIXEL_BUFFER_MAP_FAILED" << std::endl;
+		item.texture->createTextureObject();
+		item.texture->uploadImage(item.image, item.image.pixels);
+		Texture::freeImage(item.image);
+		lData.uploads.push_back({ item.texture, pixelBuffer, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) }); //the buffer goes back to the free list with it
+		return;
+	}
+
+	FillingUpload* upload = new FillingUpload();
+	upload->texture = item.texture;
+	upload->image = std::move(item.image);
+	upload->pixelBuffer = pixelBuffer;
+	upload->offset = offset;
+	upload->size = size;
+	lData.filling.emplace_back(upload);
+
+	ThreadPool::getShared().enqueue([upload, mapped]()
+		{
+			memcpy(mapped, upload->image.pixels + upload->offset, upload->size);
+			upload->filled = true;
+		});
+}
+
+//the worker is done with the buffer, unmap it and let the gpu pull the pixels from it
+static void finishFill(FillingUpload& upload)
+{
+	GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.pixelBuffer);
+	upload.texture->createTextureObject();
+	if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE)
+		upload.texture->uploadImage(upload.image, nullptr, upload.offset); //offsets into the bound buffer, the copy happens on the gpu's time
+	else //contents got lost (display mode change...), go from client memory instead
+	{
+		GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		upload.texture->uploadImage(upload.image, upload.image.pixels);
+	}
+	GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	Texture::freeImage(upload.image);
+
+	lData.uploads.push_back({ upload.texture, upload.pixelBuffer, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+
+	lData.stats.uploadedCount++;
+	lData.stats.uploadedBytes += upload.size;
+}
+
+void TextureLoader::load(Texture* texture, const char* name)
+{
+	texture->loading = true;
+	lData.decodingCount++;
+
+	std::string path = name; //the caller's string might not outlive the job
+	ThreadPool::getShared().enqueue([texture, path]()
+		{
+			DecodedTexture item;
+			item.texture = texture;
+			if (!Texture::decodeImage(path.c_str(), item.image)) //still handed over (without pixels) so update knows it's done with it
+			{
+				std::cout << "ERROR::TEXTURE_LOADER::DECODE_FAILED " << path << std::endl;
+				Texture::freeImage(item.image);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(lData.decodedMutex);
+				lData.decoded.push_back(std::move(item));
+			}
+
+			lData.decodingCount--;
+		});
+}
+
+void TextureLoader::release(Texture* texture)
+{
+	if (!texture->loading)
+		delete texture;
+	else
+		lData.released.push_back(texture);
+}
+
+void TextureLoader::releaseFromAnyThread(Texture* texture)
+{
+	if (RenderThread::isRenderThread())
+	{
+		release(texture);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(lData.pendingReleaseMutex);
+	lData.pendingReleases.push_back(texture);
+}
+
+static void releasePending()
+{
+	std::vector<Texture*> pending;
+	{
+		std::lock_guard<std::mutex> lock(lData.pendingReleaseMutex);
+		pending.swap(lData.pendingReleases);
+	}
+
+	for (Texture* texture : pending)
+		TextureLoader::release(texture);
+}
+
+void TextureLoader::update()
+{
+	lData.stats.uploadedCount = 0;
+	lData.stats.uploadedBytes = 0;
+
+	releasePending();
+
+	//retire the uploads the gpu finished, never waits
+	for (size_t i = 0; i < lData.uploads.size();)
+	{
+		PendingUpload& upload = lData.uploads[i];
+		GLenum status = glClientWaitSync(upload.fence, 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+		{
+			upload.texture->ready = true;
+			upload.texture->loading = false;
+			glDeleteSync(upload.fence);
+			lData.freePixelBuffers.push_back(upload.pixelBuffer);
+
+			upload = lData.uploads.back();
+			lData.uploads.pop_back();
+		}
+		else
+			i++;
+	}
+
+	//upload what the workers copied since the last frame
+	for (size_t i = 0; i < lData.filling.size();)
+	{
+		if (lData.filling[i]->filled)
+		{
+			finishFill(*lData.filling[i]);
+			lData.filling.erase(lData.filling.begin() + i);
+		}
+		else
+			i++;
+	}
+
+	//take what fits in this frame's budget
+	std::vector<DecodedTexture> batch;
+	{
+		std::lock_guard<std::mutex> lock(lData.decodedMutex);
+		size_t count = 0;
+		size_t bytes = 0;
+		size_t offset, size;
+		while (count < lData.decoded.size())
+		{
+			uploadRange(lData.decoded[count].image, offset, size);
+			if (count > 0 && bytes + size > maxUploadBytesPerFrame)
+				break;
+			bytes += size;
+			count++;
+		}
+
+		batch.assign(std::make_move_iterator(lData.decoded.begin()), std::make_move_iterator(lData.decoded.begin() + count));
+		lData.decoded.erase(lData.decoded.begin(), lData.decoded.begin() + count);
+	}
+
+	for (DecodedTexture& item : batch)
+	{
+		if (item.image.pixels != nullptr)
+			startFill(item);
+		else //keeps the placeholder
+			item.texture->loading = false;
+	}
+
+	//delete released textures the loader doesn't reference anymore
+	for (size_t i = 0; i < lData.released.size();)
+	{
+		Texture* texture = lData.released[i];
+		if (!texture->loading)
+		{
+			delete texture;
+			lData.released[i] = lData.released.back();
+			lData.released.pop_back();
+		}
+		else
+			i++;
+	}
+
+	lData.stats.decodingCount = lData.decodingCount;
+	lData.stats.fillingCount = (unsigned int)lData.filling.size();
+	lData.stats.uploadingCount = (unsigned int)lData.uploads.size();
+}
+
+void TextureLoader::shutDown()
+{
+	while (lData.decodingCount > 0) //the workers still write into lData
+		ThreadPool::getShared().waitIdle();
+
+	releasePending();
+
+	for (DecodedTexture& item : lData.decoded)
+		Texture::freeImage(item.image);
+	lData.decoded.clear();
+
+	while (!lData.filling.empty()) //the workers still write into the mapped buffers
+	{
+		ThreadPool::getShared().waitIdle();
+		for (std::unique_ptr<FillingUpload>& upload : lData.filling)
+		{
+			GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, upload->pixelBuffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			Texture::freeImage(upload->image);
+			lData.freePixelBuffers.push_back(upload->pixelBuffer);
+		}
+		GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		lData.filling.clear();
+	}
+
+	for (PendingUpload& upload : lData.uploads)
+	{
+		glDeleteSync(upload.fence);
+		lData.freePixelBuffers.push_back(upload.pixelBuffer);
+	}
+	lData.uploads.clear();
+
+	//nothing references them anymore
+	for (Texture* texture : lData.released)
+		delete texture;
+	lData.released.clear();
+
+	if (!lData.freePixelBuffers.empty())
+	{
+		glDeleteBuffers((GLsizei)lData.freePixelBuffers.size(), lData.freePixelBuffers.data());
+		for (GLuint pixelBuffer : lData.freePixelBuffers)
+			GLState::onBufferDeleted(pixelBuffer);
+	}
+	lData.freePixelBuffers.clear();
+}
+
+const TextureLoader::Stats& TextureLoader::getStats()
+{
+	return lData.stats;
+}
@@ -0,0 +1,31 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include "Texture.h"
+
+//streams textures in without stalling the frame: images are decoded on the shared worker pool, the GL thread maps a
+//pixel unpack buffer that a worker copies them into (cooked textures straight from the mapped file, only the levels
+//needed up front), then the upload is issued from the buffer and a fence tells when the texture becomes ready
+class TextureLoader
+{
+public:
+	static void load(Texture* texture, const char* name); //any thread, the texture must not be ready yet (unless Texture::reload does it)
+	static void release(Texture* texture); //GL thread, deletes the texture as soon as the loader is done with it
+	static void releaseFromAnyThread(Texture* texture); //release right away on the GL thread, otherwise on the next update
+	static void update(); //GL thread, once per frame: starts uploads for decoded images and retires finished ones
+	static void shutDown(); //GL thread, waits for the decodes in flight and frees the pixel buffers
+
+	//stats
+	struct Stats
+	{
+		unsigned int decodingCount; //queued or running on the workers
+		unsigned int fillingCount; //being copied into mapped pixel buffers on the workers
+		unsigned int uploadingCount; //waiting on their fence
+		unsigned int uploadedCount; //this frame
+		size_t uploadedBytes; //this frame
+	};
+
+	static const Stats& getStats();
+};
+
+#endif
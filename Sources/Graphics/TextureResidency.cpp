@@ -0,0 +1,114 @@
+#include "TextureResidency.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <unordered_set>
+
+struct ResidencyData
+{
+	std::unordered_set<Texture*> textures;
+	size_t budget = 512 * 1024 * 1024;
+	unsigned int unusedFrames = 300;
+	TextureResidency::Stats stats = {};
+};
+
+static ResidencyData resData;
+
+void TextureResidency::setBudget(size_t bytes)
+{
+	resData.budget = bytes;
+}
+
+size_t TextureResidency::getBudget()
+{
+	return resData.budget;
+}
+
+void TextureResidency::setUnusedFrames(unsigned int frames)
+{
+	resData.unusedFrames = frames;
+}
+
+void TextureResidency::onResize(Texture* texture, size_t oldBytes, size_t newBytes)
+{
+	resData.textures.insert(texture);
+	resData.stats.residentBytes += newBytes;
+	resData.stats.residentBytes -= oldBytes;
+}
+
+void TextureResidency::untrack(Texture* texture)
+{
+	if (resData.textures.erase(texture) > 0)
+		resData.stats.residentBytes -= texture->residentBytes;
+}
+
+void TextureResidency::retarget(Texture* from, Texture* to)
+{
+	if (resData.textures.erase(from) > 0)
+		resData.textures.insert(to);
+}
+
+void TextureResidency::update()
+{
+	unsigned int frame = TextureStreamer::getFrameIndex();
+	resData.stats.evictionCount = 0;
+	resData.stats.reloadCount = 0;
+
+	std::vector<Texture*> candidates;
+	unsigned int evictedCount = 0;
+	for (Texture* texture : resData.textures)
+	{
+		if (texture->evicted)
+		{
+			if (texture->lastUsedFrame == frame) //drawn (as the placeholder) this frame, bring it back
+			{
+				texture->evicted = false;
+				TextureLoader::load(texture, texture->sourcePath.c_str());
+				resData.stats.reloadCount++;
+			}
+			else
+				evictedCount++;
+		}
+		else if (texture->ready && !texture->loading && !texture->sourcePath.empty() && texture->residentBytes > 0 && frame - texture->lastUsedFrame > resData.unusedFrames)
+			candidates.push_back(texture);
+	}
+
+	if (resData.stats.residentBytes > resData.budget)
+	{
+		//least recently drawn first, the bigger one when tied
+		std::sort(candidates.begin(), candidates.end(), [](const Texture* a, const Texture* b)
+			{
+				if (a->lastUsedFrame != b->lastUsedFrame)
+					return a->lastUsedFrame < b->lastUsedFrame;
+				return a->residentBytes > b->residentBytes;
+			});
+
+		for (Texture* texture : candidates)
+		{
+			if (resData.stats.residentBytes <= resData.budget)
+				break;
+
+			texture->evict();
+			resData.stats.evictionCount++;
+			evictedCount++;
+		}
+	}
+
+	resData.stats.evictedCount = evictedCount;
+	resData.stats.textureCount = (unsigned int)resData.textures.size();
+	resData.stats.totalEvictionCount += resData.stats.evictionCount;
+	resData.stats.totalReloadCount += resData.stats.reloadCount;
+}
+
+void TextureResidency::shutDown()
+{
+	if (!resData.textures.empty())
+		std::cout << "ERROR::TEXTURE_RESIDENCY::TEXTURES_STILL_ALIVE " << resData.textures.size() << std::endl;
+	resData.textures.clear();
+	resData.stats = {};
+}
+
+const TextureResidency::Stats& TextureResidency::getStats()
+{
+	return resData.stats;
+}
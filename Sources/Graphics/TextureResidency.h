@@ -0,0 +1,41 @@
+#ifndef TEXTURE_RESIDENCY_H
+#define TEXTURE_RESIDENCY_H
+
+#include "Texture.h"
+
+//accounts the gpu memory of every texture (all resident mip levels) and keeps it under a budget: when over it, textures
+//loaded from a file that weren't drawn for a while are evicted least recently used first, an evicted texture draws as
+//the placeholder and is reloaded asynchronously as soon as something draws it again, the streamer keeps its mip levels
+//under the same budget (the single count of texture memory)
+class TextureResidency
+{
+public:
+	static void setBudget(size_t bytes); //all texture memory, streamed levels included
+	static size_t getBudget();
+	static void setUnusedFrames(unsigned int frames); //only textures not drawn for longer than this can be evicted
+
+	//GL thread, once per frame after the draws were recorded (before TextureStreamer::update)
+	static void update();
+	static void shutDown();
+
+	//texture internals
+	static void onResize(Texture* texture, size_t oldBytes, size_t newBytes);
+	static void untrack(Texture* texture);
+	static void retarget(Texture* from, Texture* to); //moved texture
+
+	//stats
+	struct Stats
+	{
+		size_t residentBytes;
+		unsigned int textureCount; //tracked, evicted ones included
+		unsigned int evictedCount; //currently evicted
+		unsigned int evictionCount; //this frame
+		unsigned int reloadCount; //this frame
+		unsigned int totalEvictionCount;
+		unsigned int totalReloadCount;
+	};
+
+	static const Stats& getStats();
+};
+
+#endif
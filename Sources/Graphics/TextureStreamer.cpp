@@ -0,0 +1,199 @@
+#include "TextureStreamer.h"
+#include "TextureResidency.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+static const int initialLevelSize = 64; //levels this big or smaller are uploaded right away
+static const unsigned int unusedFrames = 120; //frames without a draw before a texture falls back to its initial level
+static const unsigned int coarserFrames = 60; //frames a texture has to want coarser levels before its finer ones are dropped
+static const size_t maxStreamBytesPerFrame = 4 * 1024 * 1024;
+
+struct StreamedTexture
+{
+	ImageData image; //keeps the cooked file mapped
+	int residentLevel; //finest level on the gpu
+	int desiredLevel;
+	int initialLevel;
+	unsigned int coarserFrameCount; //frames in a row desiredLevel was above residentLevel
+};
+
+struct StreamerData
+{
+	std::unordered_map<Texture*, StreamedTexture> textures;
+	unsigned int frameIndex = 1; //0 means never used
+	TextureStreamer::Stats stats = {};
+};
+
+static StreamerData sData;
+
+static bool isOverBudget(size_t extraBytes) //the levels go through Texture::setResidentBytes, the residency counts them
+{
+	return TextureResidency::getStats().residentBytes + extraBytes > TextureResidency::getBudget();
+}
+
+void TextureStreamer::noteUse(Texture* texture, const glm::vec2& size)
+{
+	texture->drawScale = std::max(texture->drawScale, std::max(size.x / texture->width, size.y / texture->height));
+	texture->lastUsedFrame = sData.frameIndex;
+}
+
+int TextureStreamer::getInitialLevel(const ImageData& image)
+{
+	int levelCount = (int)image.levels.size();
+	int initialLevel = 0;
+	while (initialLevel < levelCount - 1 && std::max(image.levels[initialLevel].width, image.levels[initialLevel].height) > initialLevelSize)
+		initialLevel++;
+	return initialLevel;
+}
+
+int TextureStreamer::track(Texture* texture, const ImageData& image)
+{
+	int initialLevel = getInitialLevel(image);
+
+	StreamedTexture& streamed = sData.textures[texture];
+	streamed.image = image; //the copy shares the mapping or the converted storage, pixels stays valid after the caller frees its image
+	streamed.image.outline.clear(); //not needed for streaming
+	streamed.residentLevel = initialLevel;
+	streamed.desiredLevel = initialLevel;
+	streamed.initialLevel = initialLevel;
+	streamed.coarserFrameCount = 0;
+	texture->drawScale = 0.0f; //noted while it loaded as a 1x1 placeholder, it would ask for the whole chain
+
+	sData.stats.trackedCount = (unsigned int)sData.textures.size();
+	return initialLevel;
+}
+
+void TextureStreamer::untrack(Texture* texture)
+{
+	auto it = sData.textures.find(texture);
+	if (it == sData.textures.end())
+		return;
+
+	sData.textures.erase(it);
+	sData.stats.trackedCount = (unsigned int)sData.textures.size();
+}
+
+void TextureStreamer::retarget(Texture* from, Texture* to)
+{
+	auto it = sData.textures.find(from);
+	if (it == sData.textures.end())
+		return;
+
+	StreamedTexture streamed = std::move(it->second);
+	sData.textures.erase(it);
+	sData.textures[to] = std::move(streamed);
+}
+
+void TextureStreamer::update(float pixelsPerUnit)
+{
+	sData.stats.streamedLevelCount = 0;
+	sData.stats.evictedLevelCount = 0;
+
+	std::vector<std::pair<Texture*, StreamedTexture*>> wanting; //textures that need finer levels
+
+	for (auto& entry : sData.textures)
+	{
+		Texture* texture = entry.first;
+		StreamedTexture& streamed = entry.second;
+		int levelCount = (int)streamed.image.levels.size();
+
+		//a level is needed once its texels are bigger than a pixel on screen
+		if (texture->drawScale > 0.0f)
+		{
+			float pixelsPerTexel = texture->drawScale * pixelsPerUnit;
+			int level = (int)std::floor(-std::log2(std::max(pixelsPerTexel, 1e-6f)));
+			streamed.desiredLevel = std::min(std::max(level, 0), levelCount - 1);
+		}
+		else if (sData.frameIndex - texture->lastUsedFrame > unusedFrames)
+			streamed.desiredLevel = std::max(streamed.desiredLevel, streamed.initialLevel);
+		texture->drawScale = 0.0f;
+
+		//drawn smaller than it is resident, dropped only once that lasted, a sprite zooming back and forth
+		//around a level boundary would stream the same level in and out every frame otherwise
+		if (streamed.desiredLevel > streamed.residentLevel && ++streamed.coarserFrameCount < coarserFrames)
+			continue;
+		streamed.coarserFrameCount = 0;
+
+		if (streamed.desiredLevel > streamed.residentLevel)
+		{
+			texture->setLevelRange(streamed.desiredLevel, levelCount - 1);
+			for (int i = streamed.residentLevel; i < streamed.desiredLevel; i++)
+			{
+				texture->releaseLevel(streamed.image, i);
+				sData.stats.evictedLevelCount++;
+			}
+			streamed.residentLevel = streamed.desiredLevel;
+		}
+		else if (streamed.desiredLevel < streamed.residentLevel)
+			wanting.push_back({ texture, &streamed });
+	}
+
+	//most recently drawn first, then the ones furthest from what they need
+	std::sort(wanting.begin(), wanting.end(), [](const std::pair<Texture*, StreamedTexture*>& a, const std::pair<Texture*, StreamedTexture*>& b)
+		{
+			if (a.first->lastUsedFrame != b.first->lastUsedFrame)
+				return a.first->lastUsedFrame > b.first->lastUsedFrame;
+			return a.second->residentLevel - a.second->desiredLevel > b.second->residentLevel - b.second->desiredLevel;
+		});
+
+	//one level per texture per frame, coarse to fine, so the image sharpens progressively
+	size_t streamedBytes = 0;
+	for (auto& entry : wanting)
+	{
+		Texture* texture = entry.first;
+		StreamedTexture& streamed = *entry.second;
+		int level = streamed.residentLevel - 1;
+		size_t size = streamed.image.levels[level].size;
+
+		if (streamedBytes > 0 && streamedBytes + size > maxStreamBytesPerFrame)
+			break;
+		if (isOverBudget(size))
+			continue; //a smaller level of another texture might still fit
+
+		texture->uploadLevel(streamed.image, level, streamed.image.pixels + streamed.image.levels[level].offset);
+		texture->setLevelRange(level, (int)streamed.image.levels.size() - 1);
+		streamed.residentLevel = level;
+
+		streamedBytes += size;
+		sData.stats.streamedLevelCount++;
+	}
+
+	//over budget even after the residency evicted what wasn't drawn (budget lowered, or initial levels alone exceed it),
+	//drop the finest level of the least recently drawn textures
+	while (isOverBudget(0))
+	{
+		Texture* victim = nullptr;
+		for (auto& entry : sData.textures)
+			if (entry.second.residentLevel < (int)entry.second.image.levels.size() - 1 && (victim == nullptr || entry.first->lastUsedFrame < victim->lastUsedFrame))
+				victim = entry.first;
+		if (victim == nullptr)
+			break;
+
+		StreamedTexture& streamed = sData.textures[victim];
+		int level = streamed.residentLevel;
+		victim->setLevelRange(level + 1, (int)streamed.image.levels.size() - 1);
+		victim->releaseLevel(streamed.image, level);
+		streamed.residentLevel = level + 1;
+		streamed.desiredLevel = std::max(streamed.desiredLevel, streamed.residentLevel); //don't stream it right back in
+		sData.stats.evictedLevelCount++;
+	}
+
+	sData.frameIndex++;
+}
+
+void TextureStreamer::shutDown()
+{
+	sData.textures.clear();
+	sData.stats = {};
+}
+
+unsigned int TextureStreamer::getFrameIndex()
+{
+	return sData.frameIndex;
+}
+
+const TextureStreamer::Stats& TextureStreamer::getStats()
+{
+	return sData.stats;
+}
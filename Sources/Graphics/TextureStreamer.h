@@ -0,0 +1,40 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include "Texture.h"
+
+//keeps only the mip levels of cooked textures that are actually needed on screen resident
+//textures start with their coarse levels, the sprite batch reports how big each one is drawn, and every frame the finer
+//levels get streamed in from the (still mapped) cooked file or dropped again, clamped with GL_TEXTURE_BASE_LEVEL,
+//while staying under TextureResidency's budget (its count of resident bytes includes every streamed level), textures
+//that weren't cooked keep their full chain
+class TextureStreamer
+{
+public:
+	//sprite batch, every textured draw (size in world units)
+	static void noteUse(Texture* texture, const glm::vec2& size);
+
+	//GL thread, once per frame after the draws were recorded, pixelsPerUnit converts world sizes to screen pixels
+	static void update(float pixelsPerUnit);
+	static void shutDown();
+
+	//texture internals
+	static int track(Texture* texture, const ImageData& image); //returns the first level to upload
+	static int getInitialLevel(const ImageData& image); //what track will return, levels before it aren't needed yet
+	static void untrack(Texture* texture);
+	static void retarget(Texture* from, Texture* to); //moved texture
+
+	static unsigned int getFrameIndex();
+
+	//stats
+	struct Stats
+	{
+		unsigned int trackedCount;
+		unsigned int streamedLevelCount; //this frame
+		unsigned int evictedLevelCount; //this frame
+	};
+
+	static const Stats& getStats();
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <cstring>
 #include "Graphics/Shader.h"
 #include <filesystem>
 #include "Graphics/stb_image.h"
@@ -10,6 +11,19 @@
 #include "Graphics/Texture.h"
 #include <entt/entt.hpp>
 #include "Graphics/SpriteBatch.h"
+#include "Graphics/RenderGraph.h"
+#include "Graphics/RenderTargetPool.h"
+#include "Graphics/RenderThread.h"
+#include "Graphics/TextureLoader.h"
+#include "Graphics/TextureCache.h"
+#include "Graphics/TextureCooker.h"
+#include "Graphics/TextureStreamer.h"
+#include "Graphics/TextureResidency.h"
+#include "Graphics/SamplerCache.h"
+#include "Graphics/GLState.h"
+#include "Graphics/TextureAtlas.h"
+#include "Graphics/HotReload.h"
+#include "Engine/Scene.h"
 
 GLFWwindow* window = NULL;
 
@@ -31,12 +45,13 @@ float yaw = -90.0f;
 float roll = 0.0f;
 float sensetivity = 0.1f;
 bool firstMouse = true;
+bool useRenderThread = true; //GL submission and buffer swaps on a dedicated thread, overlapping the next frame's game logic
 float fov = 45;
 glm::vec3 sideWaysMatrix;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) //On Resize function callback
 {
-    glViewport(0, 0, width, height);
+    RenderThread::submit([width, height]() { glViewport(0, 0, width, height); }); //called by glfwPollEvents, not on the render thread
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) //called if mouse pos changed
@@ -128,33 +143,75 @@ void cleanUp()
     glfwTerminate(); //Clean up
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--cook") == 0) //offline tool mode, no window
+    {
+        TextureCooker::Format format = TextureCooker::Auto;
+        if (argc == 5 && !TextureCooker::parseFormat(argv[4], format))
+            return 1;
+        return TextureCooker::cook(argv[2], argv[3], format) ? 0 : 1;
+    }
+
     init();
 
     //enable depth testing
-    glEnable(GL_DEPTH_TEST);
+    GLState::setDepthTest(true);
 
     sideWaysMatrix = glm::normalize(glm::cross(cameraFront, cameraUp));
 
     std::string projectPath = std::filesystem::current_path().string();
     std::replace(projectPath.begin(), projectPath.end(), '\\', '/');
 
+    //let the driver compile shaders on its own threads, they're all checked on first use
+    Shader::setCompilerThreads(0xFFFFFFFF);
+
     //I should provide a relative path to the project
     Shader mainShader(projectPath + "/Assets/Shaders/Vertex.vert", projectPath + "/Assets/Shaders/Fragment.frag");
 
     ///////////////textures/////////////////////////
-    Texture mamdouh = Texture("/Assets/Textures/Mamdouh.png", true);
-    Texture container = Texture("/Assets/Textures/container.jpg", false);
+    TextureHandle mamdouh = TextureCache::load("/Assets/Textures/Mamdouh.png");
+    TextureHandle container = TextureCache::loadAsync("/Assets/Textures/container.jpg"); //white until it's uploaded
 
     int samplers[16];
     for (int i = 0; i < 16; i++)
         samplers[i] = i;
     mainShader.use();
     mainShader.setVeci("textures", 16, samplers);
+    UniformHandle modelUniform = mainShader.getUniform("model");
+    UniformHandle viewUniform = mainShader.getUniform("view");
+    UniformHandle projectionUniform = mainShader.getUniform("projection");
+
+    //edits under Assets show up while running
+    HotReload::start("/Assets");
+    HotReload::addShader(&mainShader, [&samplers](Shader& shader)
+        {
+            shader.use();
+            shader.setVeci("textures", 16, samplers);
+        });
 
     SpriteBatch::init();
 
+    RenderGraph renderGraph;
+
+    ///////////////scene/////////////////////////
+    Scene scene;
+    entt::registry& registry = scene.getRegistry();
+
+    entt::entity background = scene.createEntity();
+    registry.get<Transform>(background).position = glm::vec3(-0.5f, -0.5f, -0.1f); //background layer
+    registry.emplace<SpriteRenderer>(background, container);
+
+    entt::entity player = scene.createEntity();
+    registry.get<Transform>(player).scale = glm::vec2(0.5f);
+    registry.emplace<SpriteRenderer>(player, mamdouh, glm::vec4(1.0f, 0.0f, 1.0f, 1.0f));
+
+    const int maxFramesInFlight = 1;
+    RenderProxyBuffer renderProxies(maxFramesInFlight); //one proxy array per frame the render thread can lag behind
+
+    //GL submission runs on its own thread from here on (when enabled), every GL call has to go through RenderThread::submit
+    RenderThread::start(window, useRenderThread, maxFramesInFlight);
+
     while (!glfwWindowShouldClose(window))
     {
         deltaTime = (float)(glfwGetTime() - prevWindowTime);
@@ -163,15 +220,16 @@ int main()
         // process input
         processInput(window);
 
-        //render stuff
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); //we clear both buffers: color and depth
-
         // 2. use our shader program when we want to render an object
         float timeValue = (float)glfwGetTime();
 
-        mainShader.use();
-        
+        //simulation
+        registry.get<Transform>(player).position.y = 0.1f * sinf(timeValue);
+
+        //sync point: from here on the renderer only sees the extracted proxies
+        scene.extractRenderProxies(renderProxies);
+        const std::vector<RenderProxy>* proxies = &renderProxies.getPublished();
+
         //model matrix
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::rotate(model, 0.0f, glm::vec3(0.5f, 1.0f, 0.0f));
@@ -192,32 +250,87 @@ int main()
         glm::mat4 projection;
         projection = glm::perspective(glm::radians(fov), (float)width / height, 0.1f, 100.0f);
 
-        mainShader.setMat4("model", 1, glm::value_ptr(model));
-        mainShader.setMat4("view", 1, glm::value_ptr(view));
-        mainShader.setMat4("projection", 1, glm::value_ptr(projection));
-        
-        //wireframe mode
-        //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-        SpriteBatch::resetStats();
-        SpriteBatch::begin();
-
-        SpriteBatch::drawQuad(glm::vec2(0.0f, 0.0f), glm::vec2(0.5f, 0.5f), glm::vec4(1.0f, 0.0f, 1.0f, 1.0f), &mamdouh);
-
-        SpriteBatch::end();
-
-        mainShader.use();
-        SpriteBatch::flush();
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+        //screen pixels per world unit on the sprite plane (z = 0), drives which mips get streamed in
+        float pixelsPerUnit = framebufferHeight / (2.0f * fabsf(cameraPos.z) * tanf(glm::radians(fov) * 0.5f));
+
+        //render stuff, everything the frame needs from the game thread is captured by value
+        RenderThread::submit([&, proxies, model, view, projection, framebufferWidth, framebufferHeight, pixelsPerUnit]()
+            {
+                GLState::resetStats();
+                HotReload::update();
+                TextureLoader::update();
+
+                mainShader.use();
+                mainShader.setMat4(modelUniform, 1, glm::value_ptr(model));
+                mainShader.setMat4(viewUniform, 1, glm::value_ptr(view));
+                mainShader.setMat4(projectionUniform, 1, glm::value_ptr(projection));
+
+                //wireframe mode
+                //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+                renderGraph.clear();
+                RenderGraph::ResourceHandle backbuffer = renderGraph.importBackbuffer("backbuffer", framebufferWidth, framebufferHeight);
+                renderGraph.addPass("sprites", {}, { backbuffer }, [&](RenderGraph&)
+                    {
+                        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+                        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); //we clear both buffers: color and depth
+
+                        //recorded after the clear, the batch flushes on its own when it runs out of texture slots or vertices
+                        mainShader.use();
+                        SpriteBatch::resetStats();
+                        SpriteBatch::begin();
+
+                        for (const RenderProxy& proxy : *proxies)
+                        {
+                            if (proxy.texture != nullptr)
+                                SpriteBatch::drawQuad(proxy.position, proxy.size, proxy.color, proxy.texture.get(), proxy.depth);
+                            else
+                                SpriteBatch::drawQuad(proxy.position, proxy.size, proxy.color, proxy.depth);
+                        }
+
+                        //debug overlay, batched with the sprites
+                        SpriteBatch::drawLine(glm::vec2(-0.5f, -0.6f), glm::vec2(0.5f, -0.6f), 0.02f, glm::vec4(1.0f, 1.0f, 0.0f, 1.0f), 0.1f);
+                        SpriteBatch::drawCircle(glm::vec2(0.25f, 0.25f), 0.4f, glm::vec4(0.0f, 1.0f, 0.0f, 1.0f), 0.02f, 0.1f);
+                        SpriteBatch::drawRect(glm::vec2(-0.5f, -0.5f), glm::vec2(1.0f, 1.0f), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), 0.02f, 0.05f, 0.1f);
+
+                        SpriteBatch::end();
+                        SpriteBatch::flush();
+                    });
+                renderGraph.compile();
+                renderGraph.execute();
+                TextureResidency::update(); //sees this frame's draws
+                TextureStreamer::update(pixelsPerUnit);
+                TextureAtlas::update(); //the batch is flushed, pages can move
+                RenderTargetPool::endFrame();
+            });
 
         // check and call events and swap the buffers
-        glfwSwapBuffers(window);
+        RenderThread::endFrame();
         glfwPollEvents();
     }
 
+    RenderThread::stop();
+    HotReload::shutDown();
+
+    //drop every texture handle while the context is still alive
+    registry.clear();
+    renderProxies.clear();
+    container.reset();
+    mamdouh.reset();
+    TextureLoader::shutDown();
+    TextureCache::shutDown();
+    TextureStreamer::shutDown();
+    TextureAtlas::shutDown();
+
+    renderGraph.shutDown();
+    RenderTargetPool::shutDown();
     SpriteBatch::shutDown();
+    TextureResidency::shutDown(); //after every texture is gone
+    SamplerCache::shutDown();
 
-    container.deleteTexture();
-    mamdouh.deleteTexture();
     mainShader.deleteShader();
 
     cleanUp();